@@ -17,24 +17,75 @@
  * <http://www.gnu.org/licenses/>.
  */
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <libgen.h>
 #include <inttypes.h>
 
+#ifdef _WIN32
+#include <io.h>     // _setmode
+#else
+#define USE_THREADS
+#include <pthread.h>
+#endif
+
 #include "bluray.h"
 
-#define PKT_SIZE 192
-#define BUF_SIZE (PKT_SIZE * 1024)
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#define PKT_SIZE   192
+#define ALIGN_SIZE (PKT_SIZE * 32)
+#define BUF_SIZE   (ALIGN_SIZE * 64)
+#define MAX_JOBS   64
+#define MAX_PIDS   32
 #define MIN(a,b) (((a) < (b)) ? a : b)
 
+typedef struct {
+    int      title_no;
+    int      playlist;
+    int      chapter_start;
+    int      chapter_end;
+    int64_t  total;
+    int      status;
+} SPLICE_JOB;
+
+typedef struct {
+    const char *bdpath;
+    const char *dest;
+    const char *keyfile;
+    int         angle;
+    int         chapter_start;
+    int         chapter_end;
+    int         split;      /* one job (output file) per chapter */
+    int         verbose;
+
+    /* PIDs to keep (empty = keep all) */
+    unsigned    num_pids;
+    uint16_t    pids[MAX_PIDS];
+
+    /* job queue */
+#ifdef USE_THREADS
+    pthread_mutex_t mutex;
+#endif
+    SPLICE_JOB  jobs[MAX_JOBS];
+    unsigned    num_jobs;
+    unsigned    next_job;
+} SPLICE_CTX;
+
 static void
 _usage(char *cmd)
 {
     fprintf(stderr,
-"Usage: %s -t title    [-c first[-last]] [-k keyfile] [-a angle]  <bd path> [dest]\n"
-"       %s -p playlist [-c first[-last]] [-k keyfile] [-a angle]  <bd path> [dest]\n"
+"Usage: %s -t title    [-c first[-last]] [-k keyfile] [-a angle] [-f pid,...] <bd path> [dest]\n"
+"       %s -p playlist [-c first[-last]] [-k keyfile] [-a angle] [-f pid,...] <bd path> [dest]\n"
+"       %s -t title -t title ... [-p playlist ...] [-j threads] [...] <bd path> <dest dir>\n"
+"       %s -t title|-p playlist -s [-c first[-last]] [-j threads] [...] <bd path> <dest dir>\n"
 "Summary:\n"
 "    Given a title or playlist number and Blu-Ray directory tree,\n"
 "    find the clips that compose the movie and splice\n"
@@ -42,40 +93,363 @@ _usage(char *cmd)
 "Options:\n"
 "    t N         - Index of title to splice. First title is 1.\n"
 "    p N         - Playlist to splice.\n"
+"                  -t and -p can be repeated to splice several titles\n"
+"                  in parallel into files in <dest dir>.\n"
+"    s           - Splice each chapter into separate file in <dest dir>.\n"
+"                  Chapters are spliced in parallel.\n"
 "    a N         - Angle. First angle is 1.\n"
 "    c N or N-M  - Chapter or chapter range. First chapter is 1.\n"
 "    k keyfile   - AACS keyfile path.\n"
+"    f pid,...   - Keep only listed PIDs (and PAT, SIT, PMT, PCR), replace other packets\n"
+"                  with padding.\n"
+"    j N         - Number of parallel jobs (default: up to 4).\n"
+"                  Ignored if built without pthreads.\n"
 "    <bd path>   - Path to root of Blu-Ray directory tree.\n"
 "    [dest]      - Destination of spliced clips. stdout if not specified.\n"
-, cmd, cmd);
+, cmd, cmd, cmd, cmd);
 
     exit(EXIT_FAILURE);
 }
 
-#define OPTS "c:vt:p:k:a:"
+#define OPTS "c:vt:p:k:a:f:j:s"
 
-int
-main(int argc, char *argv[])
+static int
+_add_job(SPLICE_CTX *ctx, int title_no, int playlist)
 {
-    int title_no = -1;
-    int playlist = -1;
-    int angle = 0;
-    char *bdpath = NULL, *dest = NULL;
-    FILE *out;
-    int opt;
-    int verbose = 0;
-    int64_t total = 0;
+    if (ctx->num_jobs >= MAX_JOBS) {
+        fprintf(stderr, "Too many titles (max %d)\n", MAX_JOBS);
+        return -1;
+    }
+    ctx->jobs[ctx->num_jobs].title_no = title_no;
+    ctx->jobs[ctx->num_jobs].playlist = playlist;
+    ctx->num_jobs++;
+    return 0;
+}
+
+static int
+_parse_pids(SPLICE_CTX *ctx, const char *arg)
+{
+    while (*arg) {
+        char *end;
+        unsigned long pid = strtoul(arg, &end, 0);
+        if (end == arg || pid > 0x1fff || ctx->num_pids >= MAX_PIDS) {
+            return -1;
+        }
+        ctx->pids[ctx->num_pids++] = (uint16_t)pid;
+        arg = end;
+        if (*arg == ',') {
+            arg++;
+        }
+    }
+    return 0;
+}
+
+/*
+ * replace packets of unselected PIDs with padding.
+ * offset is the stream position of buf (partial packets are not touched).
+ */
+
+static void
+_filter_pids(const SPLICE_CTX *ctx, uint8_t *buf, size_t size, int64_t offset)
+{
+    size_t i = (PKT_SIZE - (size_t)(offset % PKT_SIZE)) % PKT_SIZE;
+
+    for (; i + PKT_SIZE <= size; i += PKT_SIZE) {
+        uint8_t *ts = buf + i + 4;
+        unsigned pid = ((ts[1] & 0x1f) << 8) | ts[2];
+        unsigned k;
+
+        /* always keep PAT, SIT, PMT and PCR */
+        if (ts[0] != 0x47 || pid <= 0x1001 || pid == 0x1fff) {
+            continue;
+        }
+        for (k = 0; k < ctx->num_pids && ctx->pids[k] != pid; k++) ;
+        if (k == ctx->num_pids) {
+            /* set pid to 0x1fff (padding) */
+            ts[2] = 0xff;
+            ts[1] |= 0x1f;
+        }
+    }
+}
+
+static int
+_write_all(int fd, const uint8_t *buf, size_t size)
+{
+    while (size > 0) {
+        ssize_t wrote = write(fd, buf, size);
+        if (wrote < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf  += wrote;
+        size -= wrote;
+    }
+    return 0;
+}
+
+static int
+_splice(const SPLICE_CTX *ctx, SPLICE_JOB *job, int fd, uint8_t *buf)
+{
+    int angle = ctx->angle;
+    int chapter_end = job->chapter_end;
     int64_t pos, end_pos = -1;
-    size_t size, wrote;
+    size_t size;
     int bytes;
+    int copy_misses = 0;
     int title_count;
     BLURAY *bd;
-    int chapter_start = 0;
-    int chapter_end = -1;
-    uint8_t buf[BUF_SIZE];
-    char *keyfile = NULL;
     BLURAY_TITLE_INFO *ti;
 
+    /* handles of the same disc image share the file system */
+    bd = bd_open(ctx->bdpath, ctx->keyfile);
+    if (bd == NULL) {
+        fprintf(stderr, "Failed to open disc: %s\n", ctx->bdpath);
+        return 1;
+    }
+
+    title_count = bd_get_titles(bd, TITLES_RELEVANT, 0);
+    if (title_count <= 0) {
+        fprintf(stderr, "No titles found: %s\n", ctx->bdpath);
+        goto fail;
+    }
+
+    if (job->title_no >= 0) {
+        if (!bd_select_title(bd, job->title_no)) {
+            fprintf(stderr, "Failed to open title: %d\n", job->title_no);
+            goto fail;
+        }
+        ti = bd_get_title_info(bd, job->title_no, angle);
+
+    } else {
+        if (!bd_select_playlist(bd, job->playlist)) {
+            fprintf(stderr, "Failed to open playlist: %d\n", job->playlist);
+            goto fail;
+        }
+        ti = bd_get_playlist_info(bd, job->playlist, angle);
+    }
+    if (!ti) {
+        goto fail;
+    }
+
+    if (angle >= (int)ti->angle_count) {
+        fprintf(stderr, "Invalid angle %d > angle count %d. Using angle 1.\n",
+                angle+1, ti->angle_count);
+        angle = 0;
+    }
+    bd_select_angle(bd, angle);
+
+    if (job->chapter_start >= (int)ti->chapter_count) {
+        fprintf(stderr, "First chapter %d > chapter count %d\n",
+                job->chapter_start+1, ti->chapter_count);
+        bd_free_title_info(ti);
+        goto fail;
+    }
+    if (chapter_end >= (int)ti->chapter_count) {
+        chapter_end = -1;
+    }
+    if (chapter_end >= 0) {
+        end_pos = bd_chapter_pos(bd, chapter_end);
+    }
+    bd_free_title_info(ti);
+
+    bd_seek_chapter(bd, job->chapter_start);
+    pos = bd_tell(bd);
+    while (end_pos < 0 || pos < end_pos) {
+        size = BUF_SIZE;
+
+        /* unencrypted clips: copy in kernel, read only boundary units */
+        if (!ctx->num_pids) {
+            int64_t copied = bd_copy(bd, fd, end_pos < 0 ? INT64_MAX : end_pos - pos);
+            if (copied < 0) {
+                goto fail;
+            }
+            if (copied > 0) {
+                job->total += copied;
+                pos = bd_tell(bd);
+                copy_misses = 0;
+                continue;
+            }
+            /* not copyable (yet): read single units for a while */
+            if (copy_misses < 64) {
+                copy_misses++;
+                size = ALIGN_SIZE;
+            }
+        }
+
+        if (size > (size_t)(end_pos - pos)) {
+            size = end_pos - pos;
+        }
+        bytes = bd_read(bd, buf, size);
+        if (bytes <= 0) {
+            break;
+        }
+        if (ctx->num_pids) {
+            _filter_pids(ctx, buf, bytes, job->total);
+        }
+        pos = bd_tell(bd);
+        if (_write_all(fd, buf, bytes) < 0) {
+            perror("Write error");
+            goto fail;
+        }
+        job->total += bytes;
+    }
+
+    bd_close(bd);
+    return 0;
+
+ fail:
+    bd_close(bd);
+    return 1;
+}
+
+static int
+_run_job(const SPLICE_CTX *ctx, SPLICE_JOB *job)
+{
+    char path[4096];
+    const char *dest = ctx->dest;
+    uint8_t *buf;
+    int fd = STDOUT_FILENO;
+    int result;
+
+    if (ctx->split) {
+        if (job->title_no >= 0) {
+            snprintf(path, sizeof(path), "%s/title_%03d_chapter_%03d.m2ts", ctx->dest, job->title_no + 1, job->chapter_start + 1);
+        } else {
+            snprintf(path, sizeof(path), "%s/%05d_chapter_%03d.m2ts", ctx->dest, job->playlist, job->chapter_start + 1);
+        }
+        dest = path;
+    } else if (ctx->num_jobs > 1) {
+        if (job->title_no >= 0) {
+            snprintf(path, sizeof(path), "%s/title_%03d.m2ts", ctx->dest, job->title_no + 1);
+        } else {
+            snprintf(path, sizeof(path), "%s/%05d.m2ts", ctx->dest, job->playlist);
+        }
+        dest = path;
+    }
+
+    buf = malloc(BUF_SIZE);
+    if (!buf) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    if (dest) {
+        fd = open(dest, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+        if (fd < 0) {
+            fprintf(stderr, "Failed to open destination: %s\n", dest);
+            free(buf);
+            return 1;
+        }
+    }
+
+    result = _splice(ctx, job, fd, buf);
+
+    if (ctx->verbose) {
+        fprintf(stderr, "Wrote %" PRId64 " bytes%s%s\n", job->total,
+                dest ? " to " : "", dest ? dest : "");
+    }
+
+    if (dest) {
+        if (close(fd) < 0) {
+            perror("Write error");
+            result = 1;
+        }
+    }
+    free(buf);
+    return result;
+}
+
+/* replace single job with one job per chapter */
+static int
+_split_chapters(SPLICE_CTX *ctx)
+{
+    SPLICE_JOB job = ctx->jobs[0];
+    BLURAY_TITLE_INFO *ti = NULL;
+    BLURAY *bd;
+    int chapter, last;
+
+    bd = bd_open(ctx->bdpath, ctx->keyfile);
+    if (bd == NULL) {
+        fprintf(stderr, "Failed to open disc: %s\n", ctx->bdpath);
+        return -1;
+    }
+    if (bd_get_titles(bd, TITLES_RELEVANT, 0) > 0) {
+        if (job.title_no >= 0) {
+            ti = bd_get_title_info(bd, job.title_no, 0);
+        } else {
+            ti = bd_get_playlist_info(bd, job.playlist, 0);
+        }
+    }
+    if (!ti) {
+        fprintf(stderr, "Failed to get title info\n");
+        bd_close(bd);
+        return -1;
+    }
+
+    last = (int)ti->chapter_count;
+    if (job.chapter_end >= 0 && job.chapter_end < last) {
+        last = job.chapter_end;
+    }
+    bd_free_title_info(ti);
+    bd_close(bd);
+
+    ctx->num_jobs = 0;
+    for (chapter = job.chapter_start; chapter < last; chapter++) {
+        if (_add_job(ctx, job.title_no, job.playlist) < 0) {
+            return -1;
+        }
+        ctx->jobs[ctx->num_jobs - 1].chapter_start = chapter;
+        ctx->jobs[ctx->num_jobs - 1].chapter_end   = chapter + 1;
+    }
+    if (ctx->num_jobs < 1) {
+        fprintf(stderr, "No chapters to splice\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void *
+_worker(void *p)
+{
+    SPLICE_CTX *ctx = p;
+
+    while (1) {
+        SPLICE_JOB *job;
+
+#ifdef USE_THREADS
+        pthread_mutex_lock(&ctx->mutex);
+#endif
+        job = ctx->next_job < ctx->num_jobs ? &ctx->jobs[ctx->next_job++] : NULL;
+#ifdef USE_THREADS
+        pthread_mutex_unlock(&ctx->mutex);
+#endif
+        if (!job) {
+            break;
+        }
+
+        job->status = _run_job(ctx, job);
+    }
+
+    return NULL;
+}
+
+int
+main(int argc, char *argv[])
+{
+    static SPLICE_CTX ctx;
+#ifdef USE_THREADS
+    pthread_t threads[MAX_JOBS];
+#endif
+    char *bdpath = NULL, *dest = NULL;
+    int opt;
+    int num_threads = 0, started = 0;
+    int result = 0;
+    int i;
+
+    ctx.chapter_end = -1;
+
     do {
         opt = getopt(argc, argv, OPTS);
         switch (opt) {
@@ -94,40 +468,54 @@ main(int argc, char *argv[])
 
             case 'c': {
                 int match;
-                match = sscanf(optarg, "%d-%d", &chapter_start, &chapter_end);
+                match = sscanf(optarg, "%d-%d", &ctx.chapter_start, &ctx.chapter_end);
                 if (match == 1) {
-                    chapter_end = chapter_start + 1;
+                    ctx.chapter_end = ctx.chapter_start + 1;
                 }
-                chapter_start--;
-                chapter_end--;
+                ctx.chapter_start--;
+                ctx.chapter_end--;
             } break;
 
             case 'k':
-                keyfile = optarg;
+                ctx.keyfile = optarg;
                 break;
 
             case 'a':
-                angle = atoi(optarg);
-                angle--;
+                ctx.angle = atoi(optarg);
+                ctx.angle--;
                 break;
 
             case 't':
-                if (playlist >= 0) {
+                if (_add_job(&ctx, atoi(optarg) - 1, -1) < 0) {
                     _usage(argv[0]);
                 }
-                title_no = atoi(optarg);
-                title_no--;
                 break;
 
             case 'p':
-                if (title_no >= 0) {
+                if (_add_job(&ctx, -1, atoi(optarg)) < 0) {
+                    _usage(argv[0]);
+                }
+                break;
+
+            case 'f':
+                if (_parse_pids(&ctx, optarg) < 0) {
+                    _usage(argv[0]);
+                }
+                break;
+
+            case 'j':
+                num_threads = atoi(optarg);
+                if (num_threads < 1) {
                     _usage(argv[0]);
                 }
-                playlist = atoi(optarg);
+                break;
+
+            case 's':
+                ctx.split = 1;
                 break;
 
             case 'v':
-                verbose = 1;
+                ctx.verbose = 1;
                 break;
 
             default:
@@ -136,99 +524,77 @@ main(int argc, char *argv[])
         }
     } while (opt != -1);
 
-    if (title_no < 0 && playlist < 0) {
+    if (ctx.num_jobs < 1) {
         _usage(argv[0]);
     }
-    if (optind < argc) {
+    for (i = 0; i < (int)ctx.num_jobs; i++) {
+        if (ctx.jobs[i].title_no < 0 && ctx.jobs[i].playlist < 0) {
+            _usage(argv[0]);
+        }
+    }
+    if (optind < argc || !bdpath) {
         _usage(argv[0]);
     }
-
-    bd = bd_open(bdpath, keyfile);
-    if (bd == NULL) {
-        fprintf(stderr, "Failed to open disc: %s\n", bdpath);
+    if ((ctx.num_jobs > 1 || ctx.split) && !dest) {
+        fprintf(stderr, "Destination directory required when splicing several titles or chapters\n");
         return 1;
     }
-
-    title_count = bd_get_titles(bd, TITLES_RELEVANT, 0);
-    if (title_count <= 0) {
-        fprintf(stderr, "No titles found: %s\n", bdpath);
+    if (ctx.split && ctx.num_jobs > 1) {
+        fprintf(stderr, "Only one title or playlist can be split to chapters\n");
         return 1;
     }
 
-    if (title_no >= 0) {
-        if (!bd_select_title(bd, title_no)) {
-            fprintf(stderr, "Failed to open title: %d\n", title_no);
-            return 1;
-        }
-        ti = bd_get_title_info(bd, title_no, angle);
+    ctx.bdpath = bdpath;
+    ctx.dest   = dest;
 
-    } else {
-        if (!bd_select_playlist(bd, playlist)) {
-            fprintf(stderr, "Failed to open playlist: %d\n", playlist);
-            return 1;
-        }
-        ti = bd_get_playlist_info(bd, playlist, angle);
+    for (i = 0; i < (int)ctx.num_jobs; i++) {
+        ctx.jobs[i].chapter_start = ctx.chapter_start;
+        ctx.jobs[i].chapter_end   = ctx.chapter_end;
     }
-
-    if (dest) {
-        out = fopen(dest, "wb");
-        if (out == NULL) {
-            fprintf(stderr, "Failed to open destination: %s\n", dest);
-            return 1;
-        }
-    } else {
-        out = stdout;
+    if (ctx.split && _split_chapters(&ctx) < 0) {
+        return 1;
     }
 
-    if (angle >= (int)ti->angle_count) {
-        fprintf(stderr, "Invalid angle %d > angle count %d. Using angle 1.\n", 
-                angle+1, ti->angle_count);
-        angle = 0;
+#ifdef _WIN32
+    if (!dest) {
+        _setmode(STDOUT_FILENO, _O_BINARY);
     }
-    bd_select_angle(bd, angle);
+#endif
 
-    if (chapter_start >= (int)ti->chapter_count) {
-        fprintf(stderr, "First chapter %d > chapter count %d\n", 
-                chapter_start+1, ti->chapter_count);
-        return 1;
-    }
-    if (chapter_end >= (int)ti->chapter_count) {
-        chapter_end = -1;
+    if (ctx.num_jobs == 1) {
+        return _run_job(&ctx, &ctx.jobs[0]);
     }
-    if (chapter_end >= 0) {
-        end_pos = bd_chapter_pos(bd, chapter_end);
+
+#ifdef USE_THREADS
+    if (num_threads < 1) {
+        num_threads = MIN((int)ctx.num_jobs, 4);
     }
-    bd_free_title_info(ti);
+    num_threads = MIN(num_threads, (int)ctx.num_jobs);
 
-    bd_seek_chapter(bd, chapter_start);
-    pos = bd_tell(bd);
-    while (end_pos < 0 || pos < end_pos) {
-        size = BUF_SIZE;
-        if (size > (size_t)(end_pos - pos)) {
-            size = end_pos - pos;
-        }
-        bytes = bd_read(bd, buf, size);
-        if (bytes <= 0) {
-            break;
-        }
-        pos = bd_tell(bd);
-        wrote = fwrite(buf, 1, bytes, out);
-        if (wrote != (size_t)bytes) {
-            fprintf(stderr, "read/write sizes do not match: %d/%zu\n", bytes, wrote);
-        }
-        if (wrote == 0) {
-            if (ferror(out)) {
-                perror("Write error");
-            }
+    pthread_mutex_init(&ctx.mutex, NULL);
+
+    for (started = 0; started < num_threads; started++) {
+        if (pthread_create(&threads[started], NULL, _worker, &ctx)) {
             break;
         }
-        total += wrote;
     }
-    if (verbose) {
-        fprintf(stderr, "Wrote %" PRId64 " bytes\n", total);
+    if (!started) {
+        /* no threads, run jobs here */
+        _worker(&ctx);
+    }
+    for (i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
     }
-    bd_close(bd);
-    fclose(out);
-    return 0;
-}
 
+    pthread_mutex_destroy(&ctx.mutex);
+#else
+    (void)num_threads;
+    (void)started;
+    _worker(&ctx);
+#endif
+
+    for (i = 0; i < (int)ctx.num_jobs; i++) {
+        result |= ctx.jobs[i].status;
+    }
+    return result;
+}
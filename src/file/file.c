@@ -27,6 +27,7 @@
 #include "util/macro.h"
 #include "util/strutl.h"
 
+#include <inttypes.h>
 #include <stdio.h>  // SEEK_*
 #include <string.h> // strchr
 
@@ -45,6 +46,34 @@ int64_t file_size(BD_FILE_H *fp)
     return length;
 }
 
+int64_t file_seek_readv(BD_FILE_H *fp, const FILE_IOVEC *iov, unsigned iovcnt, int64_t offset)
+{
+    int64_t  got = 0;
+    unsigned ii;
+
+    if (file_seek(fp, offset, SEEK_SET) != offset) {
+        BD_DEBUG(DBG_FILE, "file_seek_readv(): seek to %" PRId64 " failed (%p)\n", offset, (void*)fp);
+        return 0;
+    }
+
+    for (ii = 0; ii < iovcnt; ii++) {
+        int64_t result;
+
+        if (!iov[ii].size) {
+            continue;
+        }
+        result = fp->read(fp, iov[ii].buf, (int64_t)iov[ii].size);
+        if (result > 0) {
+            got += result;
+        }
+        if (result != (int64_t)iov[ii].size) {
+            break;
+        }
+    }
+
+    return got;
+}
+
 int file_mkdirs(const char *path)
 {
     int result = 0;
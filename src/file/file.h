@@ -65,6 +65,41 @@ static inline BD_USED size_t file_read(BD_FILE_H *fp, uint8_t *buf, size_t size)
 
 BD_PRIVATE int64_t file_size(BD_FILE_H *fp);
 
+/*
+ * positional reads
+ *
+ * Read from given offset. Position of fp is undefined after the call.
+ * When file_can_pread(fp) is set, file position is not used and
+ * concurrent reads from the same fp are safe.
+ */
+
+typedef struct {
+    uint8_t *buf;
+    size_t   size;
+} FILE_IOVEC;
+
+BD_PRIVATE int     file_can_pread(BD_FILE_H *fp);
+BD_PRIVATE int64_t file_preadv(BD_FILE_H *fp, const FILE_IOVEC *iov, unsigned iovcnt, int64_t offset);
+
+/* fallback (seek + read) for files without positional read support */
+BD_PRIVATE int64_t file_seek_readv(BD_FILE_H *fp, const FILE_IOVEC *iov, unsigned iovcnt, int64_t offset);
+
+static inline BD_USED int64_t file_pread(BD_FILE_H *fp, uint8_t *buf, size_t size, int64_t offset)
+{
+    FILE_IOVEC iov = { buf, size };
+    return file_preadv(fp, &iov, 1, offset);
+}
+
+/*
+ * Copy file range to out_fd (at its current position) without passing
+ * data through user space. Position of fp is undefined after the call.
+ * Returns number of bytes copied, -1 if not supported by fp or failed.
+ */
+BD_PRIVATE int64_t file_copy_range(BD_FILE_H *fp, int64_t offset, int64_t size, int out_fd);
+
+/* Hint: file range will be read soon. No-op if not supported by fp. */
+BD_PRIVATE void file_prefetch(BD_FILE_H *fp, int64_t offset, int64_t size);
+
 BD_PRIVATE extern BD_FILE_H *(*file_open)(const char* filename, const char *mode);
 
 BD_PRIVATE BD_FILE_OPEN file_open_default(void);
@@ -86,7 +121,9 @@ BD_PRIVATE BD_DIR_OPEN dir_open_default(void);
  */
 
 BD_PRIVATE int file_unlink(const char *file);
+BD_PRIVATE int file_rename(const char *old_path, const char *new_path); /* replaces existing new_path */
 BD_PRIVATE int file_path_exists(const char *path);
+BD_PRIVATE char *file_path_canonical(const char *path); /* absolute path, links resolved. NULL if failed. */
 BD_PRIVATE int file_mkdir(const char *dir);
 BD_PRIVATE int file_mkdirs(const char *path);
 
@@ -23,13 +23,28 @@
 #include "config.h"
 #endif
 
+#if defined(HAVE_COPY_FILE_RANGE)
+#  define _GNU_SOURCE      /* copy_file_range, preadv, realpath */
+#elif defined(HAVE_PREADV)
+#  define _DEFAULT_SOURCE  /* preadv, realpath */
+#else
+#  define _XOPEN_SOURCE 700 /* realpath */
+#endif
+
+#if defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H)
+#  define USE_SENDFILE
+#endif
+
 #include "file.h"
+#ifdef HAVE_IO_URING
+#include "file_uring.h"
+#endif
 #include "util/macro.h"
 #include "util/logging.h"
 
 #include <errno.h>
 #include <inttypes.h>
-#include <stdio.h> // remove()
+#include <stdio.h> // remove(), rename()
 #include <stdlib.h>
 #include <string.h>
 
@@ -37,6 +52,12 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#ifdef HAVE_PREADV
+#include <sys/uio.h>
+#endif
+#ifdef USE_SENDFILE
+#include <sys/sendfile.h>
+#endif
 
 #ifdef __ANDROID__
 # undef  lseek
@@ -48,6 +69,10 @@
 static void _file_close(BD_FILE_H *file)
 {
     if (file) {
+#ifdef HAVE_IO_URING
+        /* fd number may be re-used after close() */
+        file_uring_close((int)(intptr_t)file->internal);
+#endif
         if (close((int)(intptr_t)file->internal)) {
             BD_DEBUG(DBG_CRIT | DBG_FILE, "Error closing POSIX file (%p)\n", (void*)file);
         }
@@ -182,6 +207,185 @@ static BD_FILE_H *_file_open(const char* filename, const char *cmode)
 
 BD_FILE_H* (*file_open)(const char* filename, const char *mode) = _file_open;
 
+void file_prefetch(BD_FILE_H *file, int64_t offset, int64_t size)
+{
+    /* only handles opened with _file_open() carry a file descriptor */
+    if (!file || file->close != _file_close || size <= 0) {
+        return;
+    }
+
+#ifdef HAVE_IO_URING
+    {
+        int64_t queued = file_uring_prefetch((int)(intptr_t)file->internal, offset, size);
+        if (queued >= size) {
+            return;
+        }
+        if (queued > 0) {
+            /* ring is full: hint the rest */
+            offset += queued;
+            size   -= queued;
+        }
+    }
+#endif
+
+#ifdef POSIX_FADV_WILLNEED
+    if (posix_fadvise((int)(intptr_t)file->internal, (off_t)offset, (off_t)size, POSIX_FADV_WILLNEED)) {
+        BD_DEBUG(DBG_FILE, "posix_fadvise() failed (%p)\n", (void*)file);
+    }
+#else
+    (void)offset;
+#endif
+}
+
+int file_can_pread(BD_FILE_H *file)
+{
+#ifdef HAVE_PREAD
+    /* only handles opened with _file_open() carry a file descriptor */
+    return file && file->close == _file_close;
+#else
+    (void)file;
+    return 0;
+#endif
+}
+
+#ifdef HAVE_PREAD
+static int64_t _file_preadv(BD_FILE_H *file, const FILE_IOVEC *iov, unsigned iovcnt, int64_t offset)
+{
+    int      fd   = (int)(intptr_t)file->internal;
+    int64_t  got  = 0;
+    unsigned ii   = 0;
+    size_t   skip = 0;  /* bytes already read to iov[ii] */
+
+    for (;;) {
+        ssize_t result;
+
+        while (ii < iovcnt && skip >= iov[ii].size) {
+            skip -= iov[ii].size;
+            ii++;
+        }
+        if (ii >= iovcnt) {
+            break;
+        }
+
+#ifdef HAVE_IO_URING
+        /* completed read-ahead */
+        result = (ssize_t)file_uring_read(fd, offset + got, iov[ii].buf + skip, (int64_t)(iov[ii].size - skip));
+        if (result > 0) {
+            got  += result;
+            skip += (size_t)result;
+            continue;
+        }
+#endif
+
+#ifdef HAVE_PREADV
+        struct iovec v[16];
+        unsigned     n;
+        for (n = 0; n < 16 && ii + n < iovcnt; n++) {
+            v[n].iov_base = iov[ii + n].buf  + (n ? 0 : skip);
+            v[n].iov_len  = iov[ii + n].size - (n ? 0 : skip);
+        }
+        result = preadv(fd, v, (int)n, (off_t)(offset + got));
+#else
+        result = pread(fd, iov[ii].buf + skip, iov[ii].size - skip, (off_t)(offset + got));
+#endif
+        if (result < 0) {
+            if (errno != EINTR) {
+                BD_DEBUG(DBG_FILE, "pread() failed (%p)\n", (void*)file);
+                break;
+            }
+            continue;
+        } else if (result == 0) {
+            // hit EOF.
+            break;
+        }
+
+        got  += result;
+        skip += (size_t)result;
+    }
+
+    return got;
+}
+#endif
+
+int64_t file_preadv(BD_FILE_H *file, const FILE_IOVEC *iov, unsigned iovcnt, int64_t offset)
+{
+#ifdef HAVE_PREAD
+    if (file_can_pread(file)) {
+        if (offset < 0) {
+            BD_DEBUG(DBG_FILE | DBG_CRIT, "Ignoring invalid read offset %" PRId64 " (%p)\n", offset, (void*)file);
+            return 0;
+        }
+        return _file_preadv(file, iov, iovcnt, offset);
+    }
+#endif
+    return file_seek_readv(file, iov, iovcnt, offset);
+}
+
+#if defined(HAVE_COPY_FILE_RANGE) || defined(USE_SENDFILE)
+static ssize_t _copy_chunk(int in_fd, int64_t offset, int out_fd, size_t size, int *use_sendfile)
+{
+    off_t   in = (off_t)offset;
+    ssize_t n  = -1;
+
+#ifdef HAVE_COPY_FILE_RANGE
+    if (!*use_sendfile) {
+        n = copy_file_range(in_fd, &in, out_fd, NULL, size, 0);
+        if (n >= 0 || (errno != EXDEV && errno != ENOSYS && errno != EINVAL && errno != EOPNOTSUPP)) {
+            return n;
+        }
+        /* not supported between these files */
+        *use_sendfile = 1;
+    }
+#else
+    *use_sendfile = 1;
+#endif
+#ifdef USE_SENDFILE
+    n = sendfile(out_fd, in_fd, &in, size);
+#endif
+
+    return n;
+}
+#endif
+
+int64_t file_copy_range(BD_FILE_H *file, int64_t offset, int64_t size, int out_fd)
+{
+#if defined(HAVE_COPY_FILE_RANGE) || defined(USE_SENDFILE)
+    int     fd   = (int)(intptr_t)file->internal;
+    int     use_sendfile = 0;
+    int64_t done = 0;
+
+    /* only handles opened with _file_open() carry a file descriptor */
+    if (file->close != _file_close || offset < 0 || size <= 0) {
+        return -1;
+    }
+
+    while (done < size) {
+        size_t  chunk = (size_t)BD_MIN(size - done, (int64_t)1 << 30);
+        ssize_t n     = _copy_chunk(fd, offset + done, out_fd, chunk, &use_sendfile);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            BD_DEBUG(DBG_FILE, "copy_file_range() failed (%p): %d\n", (void*)file, errno);
+            break;
+        }
+        if (n == 0) {
+            // hit EOF.
+            break;
+        }
+        done += n;
+    }
+
+    return done > 0 ? done : -1;
+#else
+    (void)file;
+    (void)offset;
+    (void)size;
+    (void)out_fd;
+    return -1;
+#endif
+}
+
 BD_FILE_OPEN file_open_default(void)
 {
     return _file_open;
@@ -192,6 +396,16 @@ int file_unlink(const char *file)
     return remove(file);
 }
 
+int file_rename(const char *old_path, const char *new_path)
+{
+    return rename(old_path, new_path);
+}
+
+char *file_path_canonical(const char *path)
+{
+    return realpath(path, NULL);
+}
+
 int file_path_exists(const char *path)
 {
     struct stat s;
@@ -0,0 +1,416 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#define _GNU_SOURCE  /* syscall(), MAP_POPULATE */
+
+#include "file_uring.h"
+
+#include "util/logging.h"
+#include "util/macro.h"
+#include "util/mutex.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define URING_BUFFERS     32            /* max. requests in flight / completed reads kept */
+#define URING_CHUNK_SIZE  (256 * 1024)  /* size of single read (and buffer) */
+
+typedef struct {
+    int       fd;         /* -1: unused or file closed */
+    int       busy;       /* request in flight */
+    int64_t   offset;     /* file offset of buffer (URING_CHUNK_SIZE aligned) */
+    unsigned  len;        /* bytes read (valid when not busy) */
+    uint64_t  seq;        /* last use (eviction order) */
+} URING_SLOT;
+
+typedef struct {
+    int       fd;
+    unsigned  entries;
+    unsigned  in_flight;
+
+    /* submission queue */
+    void     *sq_ring;
+    size_t    sq_ring_size;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+
+    /* completion queue */
+    void     *cq_ring;
+    size_t    cq_ring_size;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    /* registered buffers (one per slot) */
+    void      *buf;
+    URING_SLOT slot[URING_BUFFERS];
+    uint64_t   seq;
+} URING;
+
+static BD_MUTEX uring_mutex;   /* statically allocated, protects all below */
+static URING   *uring;
+static int      uring_disabled;
+
+/*
+ * ring setup
+ */
+
+static void _uring_free(URING *u)
+{
+    if (u->sqes) {
+        munmap(u->sqes, u->entries * sizeof(struct io_uring_sqe));
+    }
+    if (u->cq_ring && u->cq_ring != u->sq_ring) {
+        munmap(u->cq_ring, u->cq_ring_size);
+    }
+    if (u->sq_ring) {
+        munmap(u->sq_ring, u->sq_ring_size);
+    }
+    if (u->fd >= 0) {
+        close(u->fd);
+    }
+    free(u->buf);
+    free(u);
+}
+
+static URING *_uring_init(void)
+{
+    struct io_uring_params p;
+    struct iovec iov[URING_BUFFERS];
+    unsigned ii;
+    URING *u;
+
+    u = calloc(1, sizeof(*u));
+    if (!u) {
+        return NULL;
+    }
+
+    memset(&p, 0, sizeof(p));
+    u->fd = (int)syscall(__NR_io_uring_setup, URING_BUFFERS, &p);
+    if (u->fd < 0) {
+        BD_DEBUG(DBG_FILE, "io_uring_setup() failed: %d\n", errno);
+        free(u);
+        return NULL;
+    }
+    u->entries = p.sq_entries;
+
+    u->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_ring_size = p.cq_off.cqes  + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (u->cq_ring_size > u->sq_ring_size) {
+            u->sq_ring_size = u->cq_ring_size;
+        }
+        u->cq_ring_size = u->sq_ring_size;
+    }
+
+    u->sq_ring = mmap(NULL, u->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      u->fd, IORING_OFF_SQ_RING);
+    if (u->sq_ring == MAP_FAILED) {
+        u->sq_ring = NULL;
+        goto error;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        u->cq_ring = u->sq_ring;
+    } else {
+        u->cq_ring = mmap(NULL, u->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          u->fd, IORING_OFF_CQ_RING);
+        if (u->cq_ring == MAP_FAILED) {
+            u->cq_ring = NULL;
+            goto error;
+        }
+    }
+    u->sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   u->fd, IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED) {
+        u->sqes = NULL;
+        goto error;
+    }
+
+    u->sq_head  = (unsigned *)((uint8_t *)u->sq_ring + p.sq_off.head);
+    u->sq_tail  = (unsigned *)((uint8_t *)u->sq_ring + p.sq_off.tail);
+    u->sq_mask  = (unsigned *)((uint8_t *)u->sq_ring + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)((uint8_t *)u->sq_ring + p.sq_off.array);
+    u->cq_head  = (unsigned *)((uint8_t *)u->cq_ring + p.cq_off.head);
+    u->cq_tail  = (unsigned *)((uint8_t *)u->cq_ring + p.cq_off.tail);
+    u->cq_mask  = (unsigned *)((uint8_t *)u->cq_ring + p.cq_off.ring_mask);
+    u->cqes     = (struct io_uring_cqe *)((uint8_t *)u->cq_ring + p.cq_off.cqes);
+
+    /* completed reads stay in registered buffers until consumed by file_uring_read() */
+    if (posix_memalign(&u->buf, 4096, (size_t)URING_BUFFERS * URING_CHUNK_SIZE)) {
+        u->buf = NULL;
+        goto error;
+    }
+    for (ii = 0; ii < URING_BUFFERS; ii++) {
+        iov[ii].iov_base = (uint8_t *)u->buf + (size_t)ii * URING_CHUNK_SIZE;
+        iov[ii].iov_len  = URING_CHUNK_SIZE;
+        u->slot[ii].fd   = -1;
+    }
+    if (syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_BUFFERS, iov, URING_BUFFERS) < 0) {
+        BD_DEBUG(DBG_FILE, "io_uring_register() failed: %d\n", errno);
+        goto error;
+    }
+
+    BD_DEBUG(DBG_FILE, "io_uring read-ahead enabled (%u entries)\n", u->entries);
+    return u;
+
+ error:
+    BD_DEBUG(DBG_FILE | DBG_CRIT, "io_uring initialization failed\n");
+    _uring_free(u);
+    return NULL;
+}
+
+/*
+ * requests
+ */
+
+static void _uring_reap(URING *u)
+{
+    unsigned head = *u->cq_head;
+    unsigned tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+        URING_SLOT *s = &u->slot[cqe->user_data];
+
+        if (cqe->res < 0) {
+            BD_DEBUG(DBG_FILE, "io_uring read-ahead failed: %d\n", -cqe->res);
+        }
+
+        s->busy = 0;
+        s->len  = cqe->res > 0 ? (unsigned)cqe->res : 0;
+        if (!s->len) {
+            s->fd = -1;
+        }
+
+        u->in_flight--;
+        head++;
+    }
+
+    __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+}
+
+static URING_SLOT *_find_slot(URING *u, int fd, int64_t offset)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < URING_BUFFERS; ii++) {
+        if (u->slot[ii].fd == fd && u->slot[ii].offset == offset) {
+            return &u->slot[ii];
+        }
+    }
+    return NULL;
+}
+
+/* unused slot, or least recently used completed read */
+static int _alloc_slot(URING *u)
+{
+    int ii, best = -1;
+
+    for (ii = 0; ii < URING_BUFFERS; ii++) {
+        const URING_SLOT *s = &u->slot[ii];
+        if (s->busy) {
+            continue;
+        }
+        if (s->fd < 0) {
+            return ii;
+        }
+        if (best < 0 || s->seq < u->slot[best].seq) {
+            best = ii;
+        }
+    }
+    return best;
+}
+
+static int64_t _uring_prefetch(URING *u, int fd, int64_t offset, int64_t size)
+{
+    unsigned tail = *u->sq_tail;
+    unsigned num  = 0;
+    int64_t  chunk, end = offset + size;
+    int      ret;
+
+    for (chunk = offset / URING_CHUNK_SIZE * URING_CHUNK_SIZE; chunk < end; chunk += URING_CHUNK_SIZE) {
+        struct io_uring_sqe *sqe;
+        int      slot;
+
+        /* already queued or read */
+        if (_find_slot(u, fd, chunk)) {
+            continue;
+        }
+
+        slot = _alloc_slot(u);
+        if (slot < 0) {
+            break;
+        }
+
+        u->slot[slot].fd     = fd;
+        u->slot[slot].busy   = 1;
+        u->slot[slot].offset = chunk;
+        u->slot[slot].len    = 0;
+        u->slot[slot].seq    = ++u->seq;
+
+        /* kernel takes its own file reference at submission:
+         * caller may close fd while the request is in flight */
+        sqe = &u->sqes[(tail + num) & *u->sq_mask];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode    = IORING_OP_READ_FIXED;
+        sqe->fd        = fd;
+        sqe->off       = (uint64_t)chunk;
+        sqe->addr      = (uint64_t)(uintptr_t)((uint8_t *)u->buf + (size_t)slot * URING_CHUNK_SIZE);
+        sqe->len       = URING_CHUNK_SIZE;
+        sqe->buf_index = (uint16_t)slot;
+        sqe->user_data = (uint64_t)slot;
+
+        u->sq_array[(tail + num) & *u->sq_mask] = (tail + num) & *u->sq_mask;
+        num++;
+    }
+
+    if (num) {
+        __atomic_store_n(u->sq_tail, tail + num, __ATOMIC_RELEASE);
+
+        /* one system call for the whole batch */
+        do {
+            ret = (int)syscall(__NR_io_uring_enter, u->fd, num, 0, 0, NULL, 0);
+        } while (ret < 0 && errno == EINTR);
+
+        if (ret < 0) {
+            BD_DEBUG(DBG_FILE | DBG_CRIT, "io_uring_enter() failed: %d\n", errno);
+            ret = 0;
+        }
+
+        if ((unsigned)ret < num) {
+            /* Drop requests the kernel did not consume: fd is not valid after return.
+             * Without SQPOLL the kernel reads the ring only inside io_uring_enter(). */
+            unsigned ii;
+            for (ii = (unsigned)ret; ii < num; ii++) {
+                URING_SLOT *s = &u->slot[u->sqes[(tail + ii) & *u->sq_mask].user_data];
+                s->busy = 0;
+                s->fd   = -1;
+            }
+            __atomic_store_n(u->sq_tail, tail + (unsigned)ret, __ATOMIC_RELEASE);
+            end = BD_MIN(end, (int64_t)u->sqes[(tail + (unsigned)ret) & *u->sq_mask].off);
+        }
+
+        u->in_flight += (unsigned)ret;
+    }
+
+    /* range covered by ring */
+    end = BD_MIN(end, chunk);
+    return end > offset ? end - offset : 0;
+}
+
+int64_t file_uring_prefetch(int fd, int64_t offset, int64_t size)
+{
+    int64_t result = -1;
+
+    if (fd < 0 || offset < 0 || size <= 0) {
+        return 0;
+    }
+
+    if (bd_mutex_lock_static(&uring_mutex) < 0) {
+        return -1;
+    }
+
+    if (!uring && !uring_disabled) {
+        uring = _uring_init();
+        uring_disabled = !uring;
+    }
+
+    if (uring) {
+        _uring_reap(uring);
+        result = _uring_prefetch(uring, fd, offset, size);
+    }
+
+    bd_mutex_unlock(&uring_mutex);
+
+    return result;
+}
+
+int64_t file_uring_read(int fd, int64_t offset, uint8_t *buf, int64_t size)
+{
+    URING_SLOT *s;
+    int64_t     chunk = offset / URING_CHUNK_SIZE * URING_CHUNK_SIZE;
+    int64_t     n = 0;
+
+    if (offset < 0 || size <= 0) {
+        return 0;
+    }
+
+    if (bd_mutex_lock_static(&uring_mutex) < 0) {
+        return 0;
+    }
+
+    if (!uring) {
+        /* nothing was ever queued */
+        bd_mutex_unlock(&uring_mutex);
+        return 0;
+    }
+
+    _uring_reap(uring);
+
+    /* requests still in flight are not waited for: caller reads from page cache */
+    s = _find_slot(uring, fd, chunk);
+    if (s && !s->busy && offset - chunk < s->len) {
+        n = BD_MIN(size, chunk + s->len - offset);
+        memcpy(buf, (uint8_t *)uring->buf + (size_t)(s - uring->slot) * URING_CHUNK_SIZE + (offset - chunk), (size_t)n);
+        s->seq = ++uring->seq;
+
+        /* consumed up to the end: release buffer */
+        if (offset + n >= chunk + s->len) {
+            s->fd = -1;
+        }
+    }
+
+    bd_mutex_unlock(&uring_mutex);
+
+    return n;
+}
+
+void file_uring_close(int fd)
+{
+    unsigned ii;
+
+    if (bd_mutex_lock_static(&uring_mutex) < 0) {
+        return;
+    }
+
+    /* buffers of requests in flight are released when request completes */
+    for (ii = 0; uring && ii < URING_BUFFERS; ii++) {
+        if (uring->slot[ii].fd == fd) {
+            uring->slot[ii].fd = -1;
+        }
+    }
+
+    bd_mutex_unlock(&uring_mutex);
+}
@@ -0,0 +1,44 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BD_FILE_URING_H_
+#define BD_FILE_URING_H_
+
+#include "util/attributes.h"
+
+#include <stdint.h>
+
+/*
+ * Asynchronous read-ahead using io_uring (Linux).
+ *
+ * Single submission ring and a small pool of registered buffers are shared
+ * by all file handles in the process. Completed reads are kept in the
+ * buffers until consumed by file_uring_read() or evicted.
+ */
+
+/* Queue read-ahead of file range. Return number of bytes queued, -1 if io_uring is not available. */
+BD_PRIVATE int64_t file_uring_prefetch(int fd, int64_t offset, int64_t size);
+
+/* Copy completed read-ahead data. Return number of bytes copied (0 if not available). Non-blocking. */
+BD_PRIVATE int64_t file_uring_read(int fd, int64_t offset, uint8_t *buf, int64_t size);
+
+/* Drop read-ahead data of file. Must be called before fd is closed. */
+BD_PRIVATE void    file_uring_close(int fd);
+
+#endif /* BD_FILE_URING_H_ */
@@ -143,6 +143,36 @@ static BD_FILE_H *_file_open(const char* filename, const char *mode)
 
 BD_FILE_H* (*file_open)(const char* filename, const char *mode) = _file_open;
 
+void file_prefetch(BD_FILE_H *file, int64_t offset, int64_t size)
+{
+    /* not implemented */
+    (void)file;
+    (void)offset;
+    (void)size;
+}
+
+int file_can_pread(BD_FILE_H *file)
+{
+    /* not implemented */
+    (void)file;
+    return 0;
+}
+
+int64_t file_preadv(BD_FILE_H *file, const FILE_IOVEC *iov, unsigned iovcnt, int64_t offset)
+{
+    return file_seek_readv(file, iov, iovcnt, offset);
+}
+
+int64_t file_copy_range(BD_FILE_H *file, int64_t offset, int64_t size, int out_fd)
+{
+    /* not implemented */
+    (void)file;
+    (void)offset;
+    (void)size;
+    (void)out_fd;
+    return -1;
+}
+
 BD_FILE_OPEN file_open_default(void)
 {
     return _file_open;
@@ -159,6 +189,18 @@ int file_unlink(const char *file)
     return _wremove(wfile);
 }
 
+int file_rename(const char *old_path, const char *new_path)
+{
+    wchar_t wold[MAX_PATH], wnew[MAX_PATH];
+
+    if (!MultiByteToWideChar(CP_UTF8, 0, old_path, -1, wold, MAX_PATH) ||
+        !MultiByteToWideChar(CP_UTF8, 0, new_path, -1, wnew, MAX_PATH)) {
+        return -1;
+    }
+
+    return MoveFileExW(wold, wnew, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+}
+
 int file_path_exists(const char *path)
 {
     wchar_t wpath[MAX_PATH];
@@ -174,6 +216,32 @@ int file_path_exists(const char *path)
     return -1;
 }
 
+char *file_path_canonical(const char *path)
+{
+    wchar_t wpath[MAX_PATH], wfull[MAX_PATH];
+    DWORD   wlen;
+    char   *result;
+    int     len;
+
+    if (!MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, MAX_PATH)) {
+        return NULL;
+    }
+    wlen = GetFullPathNameW(wpath, MAX_PATH, wfull, NULL);
+    if (!wlen || wlen >= MAX_PATH) {
+        return NULL;
+    }
+
+    len = WideCharToMultiByte(CP_UTF8, 0, wfull, -1, NULL, 0, NULL, NULL);
+    if (len <= 0) {
+        return NULL;
+    }
+    result = malloc(len);
+    if (result && !WideCharToMultiByte(CP_UTF8, 0, wfull, -1, result, len, NULL, NULL)) {
+        X_FREE(result);
+    }
+    return result;
+}
+
 int file_mkdir(const char *dir)
 {
     wchar_t wdir[MAX_PATH];
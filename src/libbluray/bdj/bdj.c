@@ -32,6 +32,7 @@
 #include "util/strutl.h"
 #include "util/macro.h"
 #include "util/logging.h"
+#include "util/trace.h"
 
 
 #include <jni.h>
@@ -1005,7 +1006,9 @@ static int _create_jvm(void *jvm_lib, const char *java_home, BDJ_CONFIG *cfg,
     }
 #endif
 
+    int64_t trace = bd_trace_begin();
     result = JNI_CreateJavaVM_fp(jvm, (void**) env, &args);
+    bd_trace_end(trace, "JNI_CreateJavaVM", NULL);
 
     while (--n >= 0) {
         X_FREE(option[n].optionString);
@@ -1076,7 +1079,10 @@ BDJAVA* bdj_open(const char *path, struct bluray *bd,
         BD_DEBUG(DBG_BDJ, "Java JNI version: %d.%d\n", version >> 16, version & 0xffff);
     }
 
-    if (!_bdj_init(env, bd, path, bdj_disc_id, cfg)) {
+    int64_t trace = bd_trace_begin();
+    int     init  = _bdj_init(env, bd, path, bdj_disc_id, cfg);
+    bd_trace_end(trace, "Libbluray.init", NULL);
+    if (!init) {
         bdj_close(bdjava);
         return NULL;
     }
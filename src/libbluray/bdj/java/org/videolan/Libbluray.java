@@ -616,6 +616,17 @@ public class Libbluray {
         return tellTimeN(nativePointer);
     }
 
+    /* timeline trace (BD_TRACE_FILE) */
+    public static long traceBegin() {
+        return traceBeginN();
+    }
+
+    public static void traceEnd(long start, String name) {
+        if (start >= 0) {
+            traceEndN(start, name);
+        }
+    }
+
     public static boolean selectRate(float rate) {
         return selectRateN(nativePointer, rate, 0) == 1 ? true : false;
     }
@@ -871,6 +882,8 @@ public class Libbluray {
     private static native Bdjo getBdjoN(long np, String name);
     private static native void updateGraphicN(long np, int width, int height, int[] rgbArray,
                                               int x0, int y0, int x1, int y1);
+    private static native long traceBeginN();
+    private static native void traceEndN(long start, String name);
 
     private static long nativePointer = 0;
     private static TitleInfo[] titleInfos = null;
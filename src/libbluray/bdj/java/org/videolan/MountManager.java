@@ -51,6 +51,15 @@ public class MountManager {
 
     /* package private, called from BDJXletContext */
     protected static String mount(int jarId, boolean classFiles) throws MountException {
+        long traceStart = Libbluray.traceBegin();
+        try {
+            return mountImpl(jarId, classFiles);
+        } finally {
+            Libbluray.traceEnd(traceStart, "MountManager.mount");
+        }
+    }
+
+    private static String mountImpl(int jarId, boolean classFiles) throws MountException {
         String jarStr = jarIdToString(jarId);
 
         logger.info("Mounting JAR: " + jarStr);
@@ -35,6 +35,7 @@
 #include "file/file.h"
 #include "util/logging.h"
 #include "util/macro.h"
+#include "util/trace.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -630,6 +631,19 @@ JNIEXPORT void JNICALL Java_org_videolan_Libbluray_updateGraphicN(JNIEnv * env,
     bd_unlock_osd_buffer(bd);
 }
 
+JNIEXPORT jlong JNICALL Java_org_videolan_Libbluray_traceBeginN(JNIEnv * env, jclass cls) {
+    return (jlong)bd_trace_begin();
+}
+
+JNIEXPORT void JNICALL Java_org_videolan_Libbluray_traceEndN(JNIEnv * env, jclass cls, jlong start, jstring jname) {
+
+    const char *name = (*env)->GetStringUTFChars(env, jname, NULL);
+    if (name) {
+        bd_trace_end((int64_t)start, name, NULL);
+        (*env)->ReleaseStringUTFChars(env, jname, name);
+    }
+}
+
 #define CC (char*)(uintptr_t)  /* cast a literal from (const char*) */
 #define VC (void*)(uintptr_t)  /* cast function pointer to void* */
 
@@ -736,6 +750,16 @@ Java_org_videolan_Libbluray_methods[] =
         CC("(JII[IIIII)V"),
         VC(Java_org_videolan_Libbluray_updateGraphicN),
     },
+    {
+        CC("traceBeginN"),
+        CC("()J"),
+        VC(Java_org_videolan_Libbluray_traceBeginN),
+    },
+    {
+        CC("traceEndN"),
+        CC("(JLjava/lang/String;)V"),
+        VC(Java_org_videolan_Libbluray_traceEndN),
+    },
 };
 
 BD_PRIVATE CPP_EXTERN const int
@@ -254,6 +254,22 @@ JNIEXPORT jobject JNICALL Java_org_videolan_Libbluray_getBdjoN
 JNIEXPORT void JNICALL Java_org_videolan_Libbluray_updateGraphicN
 (JNIEnv *, jclass, jlong, jint, jint, jintArray, jint, jint, jint, jint);
 
+/*
+ * Class:     org_videolan_Libbluray
+ * Method:    traceBeginN
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_org_videolan_Libbluray_traceBeginN
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     org_videolan_Libbluray
+ * Method:    traceEndN
+ * Signature: (JLjava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_org_videolan_Libbluray_traceEndN
+  (JNIEnv *, jclass, jlong, jstring);
+
 #ifdef __cplusplus
 }
 #endif
@@ -628,6 +628,108 @@ clpi_access_point(const CLPI_CL *cl, uint32_t pkt, int next, int angle_change, u
     return coarse_spn + entry->fine[jj].spn_ep;
 }
 
+/*
+ * EP map access
+ *
+ * EP entries are addressed with a flat index to fine table of the first
+ * (video) EP map stream.
+ */
+
+int
+clpi_ep_count(const CLPI_CL *cl)
+{
+    const CLPI_CPI *cpi = &cl->cpi;
+
+    if (cpi->num_stream_pid < 1 || !cpi->entry || cpi->entry[0].num_ep_coarse < 1) {
+        return 0;
+    }
+    return cpi->entry[0].num_ep_fine;
+}
+
+// Find coarse entry the fine entry belongs to
+static int
+_ep_coarse_idx(const CLPI_EP_MAP_ENTRY *entry, int ep)
+{
+    int lo = 0, hi = entry->num_ep_coarse - 1;
+
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (entry->coarse[mid].ref_ep_fine_id <= ep) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+static uint32_t
+_ep_spn(const CLPI_EP_MAP_ENTRY *entry, int ep)
+{
+    int ii = _ep_coarse_idx(entry, ep);
+    return (entry->coarse[ii].spn_ep & ~0x1FFFF) + entry->fine[ep].spn_ep;
+}
+
+// Returns the last EP entry at or before the given packet,
+// -1 if the packet is before the first entry
+int
+clpi_ep_find(const CLPI_CL *cl, uint32_t pkt)
+{
+    const CLPI_EP_MAP_ENTRY *entry;
+    int lo, hi;
+
+    if (clpi_ep_count(cl) < 1) {
+        return -1;
+    }
+
+    entry = &cl->cpi.entry[0];
+    lo = -1;
+    hi = entry->num_ep_fine - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (_ep_spn(entry, mid) <= pkt) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+// Returns start packet of EP entry.
+// end_pkt is set to the (estimated) end of the I-picture starting at the entry.
+uint32_t
+clpi_ep_entry(const CLPI_CL *cl, int ep, uint32_t *end_pkt, uint32_t *time)
+{
+    /* upper limit of I-picture size (bytes) for I_end_position_offset values */
+    static const uint32_t i_end_size[8] = {
+        0, 131072, 262144, 393216, 589824, 786432, 1048576, 0 };
+
+    const CLPI_EP_MAP_ENTRY *entry = &cl->cpi.entry[0];
+    int ii = _ep_coarse_idx(entry, ep);
+    uint32_t spn = (entry->coarse[ii].spn_ep & ~0x1FFFF) + entry->fine[ep].spn_ep;
+
+    if (time) {
+        *time = ((uint64_t)(entry->coarse[ii].pts_ep & ~0x01) << 18) +
+                ((uint64_t)entry->fine[ep].pts_ep << 8);
+    }
+
+    if (end_pkt) {
+        uint32_t size = i_end_size[entry->fine[ep].i_end_position_offset & 7];
+
+        /* I-picture can't continue past next entry */
+        *end_pkt = cl->clip.num_source_packets;
+        if (ep + 1 < entry->num_ep_fine) {
+            *end_pkt = _ep_spn(entry, ep + 1);
+        }
+        if (size && spn + (size + 191) / 192 < *end_pkt) {
+            *end_pkt = spn + (size + 191) / 192;
+        }
+    }
+
+    return spn;
+}
+
 static int
 _parse_extent_start_points(BITSTREAM *bits, CLPI_EXTENT_START *es)
 {
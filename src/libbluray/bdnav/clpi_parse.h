@@ -34,6 +34,11 @@ BD_PRIVATE uint32_t clpi_find_stc_spn(const struct clpi_cl *cl, uint8_t stc_id);
 BD_PRIVATE uint32_t clpi_lookup_spn(const struct clpi_cl *cl, uint32_t timestamp, int before, uint8_t stc_id);
 BD_PRIVATE uint32_t clpi_access_point(const struct clpi_cl *cl, uint32_t pkt, int next, int angle_change, uint32_t *time);
 
+/* EP map (video) entries */
+BD_PRIVATE int      clpi_ep_count(const struct clpi_cl *cl);
+BD_PRIVATE int      clpi_ep_find(const struct clpi_cl *cl, uint32_t pkt);
+BD_PRIVATE uint32_t clpi_ep_entry(const struct clpi_cl *cl, int ep, uint32_t *end_pkt, uint32_t *time);
+
 /* preserved for old clpi API */
 BD_PRIVATE struct clpi_cl* clpi_parse(const char *path);
 BD_PRIVATE struct clpi_cl* clpi_copy(const struct clpi_cl* src_cl);  /* deep copy */
@@ -32,6 +32,7 @@
 #include "util/logging.h"
 #include "util/macro.h"
 #include "util/strutl.h"
+#include "util/trace.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -309,6 +310,7 @@ static INDX_ROOT *_indx_get(BD_DISC *disc, const char *path)
 INDX_ROOT *indx_get(BD_DISC *disc)
 {
     INDX_ROOT *index;
+    int64_t    trace = bd_trace_begin();
 
     index = _indx_get(disc, "BDMV" DIR_SEP "index.bdmv");
 
@@ -317,6 +319,7 @@ INDX_ROOT *indx_get(BD_DISC *disc)
         index = _indx_get(disc, "BDMV" DIR_SEP "BACKUP" DIR_SEP "index.bdmv");
     }
 
+    bd_trace_end(trace, "indx_get", NULL);
     return index;
 }
 
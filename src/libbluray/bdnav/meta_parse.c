@@ -28,11 +28,11 @@
 #include "disc/disc.h"
 
 #include "file/file.h"
-#include "util/bits.h"
 #include "util/logging.h"
 #include "util/macro.h"
 #include "util/strutl.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -43,7 +43,7 @@
 #ifdef HAVE_LIBXML2
 #include <libxml/parser.h>
 #include <libxml/xmlmemory.h>
-#include <libxml/tree.h>
+#include <libxml/xmlreader.h>
 #endif
 
 #ifdef _WIN32
@@ -57,151 +57,311 @@
 #define XML_FREE(p) (xmlFree(p), p = NULL)
 
 #define MAX_META_FILE_SIZE  0xfffff
+#define MAX_XML_DEPTH       32
+
+#define META_DL_DIR  "BDMV" DIR_SEP "META" DIR_SEP "DL"
+#define META_TN_DIR  "BDMV" DIR_SEP "META" DIR_SEP "TN"
+
+/*
+ * Meta files are listed when META_ROOT is created.
+ * Each file is parsed when it is requested for the first time.
+ */
+
+typedef struct {
+    META_DL  dl;
+    uint8_t  parsed;
+} META_DL_ENTRY;
+
+typedef struct {
+    META_TN  tn;
+    uint8_t  parsed;
+} META_TN_ENTRY;
 
 struct meta_root {
+    struct bd_disc      *disc;
+
     uint8_t              dl_count;
-    META_DL *            dl_entries;
+    META_DL_ENTRY *      dl_entries;
 
     unsigned             tn_count;
-    META_TN             *tn_entries;
+    META_TN_ENTRY       *tn_entries;
 };
 
 #ifdef HAVE_LIBXML2
-static void _parseManifestNode(xmlNode * a_node, META_DL *disclib)
+
+/*
+ * streaming parser
+ */
+
+typedef void (*element_fp)(xmlTextReaderPtr reader, const xmlChar *parent, const xmlChar *name, void *ctx);
+
+static char *_read_content(xmlTextReaderPtr reader)
 {
-    xmlNode *cur_node = NULL;
-    xmlChar *tmp;
+    xmlChar *content = xmlTextReaderReadString(reader);
+    if (!content) {
+        content = xmlStrdup(BAD_CAST_CONST "");
+    }
+    return (char *)content;
+}
 
-    for (cur_node = a_node; cur_node; cur_node = cur_node->next) {
-        if (cur_node->type == XML_ELEMENT_NODE) {
-            if (xmlStrEqual(cur_node->parent->name, BAD_CAST_CONST "title")) {
-                if (xmlStrEqual(cur_node->name, BAD_CAST_CONST "name")) {
-                    disclib->di_name = (char*)xmlNodeGetContent(cur_node);
-                }
-                if (xmlStrEqual(cur_node->name, BAD_CAST_CONST "alternative")) {
-                    disclib->di_alternative = (char*)xmlNodeGetContent(cur_node);
-                }
-                if (xmlStrEqual(cur_node->name, BAD_CAST_CONST "numSets")) {
-                    disclib->di_num_sets = atoi((char*)(tmp = xmlNodeGetContent(cur_node)));
-                    XML_FREE(tmp);
+static int _parse_xml(BD_DISC *disc, const char *dir, const char *file, element_fp element, void *ctx)
+{
+    const xmlChar   *path[MAX_XML_DEPTH];
+    xmlTextReaderPtr reader;
+    uint8_t *data = NULL;
+    size_t   size;
+    int      ret;
+
+    size = disc_read_file(disc, dir, file, &data);
+    if (!data || size == 0 || size > MAX_META_FILE_SIZE) {
+        BD_DEBUG(DBG_DIR, "Failed to read %s/%s\n", dir, file);
+        X_FREE(data);
+        return -1;
+    }
+
+    reader = xmlReaderForMemory((const char *)data, (int)size, NULL, NULL, 0);
+    if (!reader) {
+        BD_DEBUG(DBG_DIR, "Failed to parse %s/%s\n", dir, file);
+        X_FREE(data);
+        return -1;
+    }
+
+    while ((ret = xmlTextReaderRead(reader)) == 1) {
+        if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT) {
+            int depth = xmlTextReaderDepth(reader);
+            if (depth >= 0 && depth < MAX_XML_DEPTH) {
+                /* names are owned by reader dictionary */
+                path[depth] = xmlTextReaderConstLocalName(reader);
+                if (depth > 0 && path[depth] && path[depth - 1]) {
+                    element(reader, path[depth - 1], path[depth], ctx);
                 }
-                if (xmlStrEqual(cur_node->name, BAD_CAST_CONST "setNumber")) {
-                    disclib->di_set_number = atoi((char*)(tmp = xmlNodeGetContent(cur_node)));
-                    XML_FREE(tmp);
+            }
+        }
+    }
+
+    if (ret < 0) {
+        BD_DEBUG(DBG_DIR, "Failed to parse %s/%s\n", dir, file);
+    }
+
+    xmlFreeTextReader(reader);
+    X_FREE(data);
+
+    return ret < 0 ? -1 : 0;
+}
+
+/*
+ * disc library (DL) files
+ */
+
+typedef struct {
+    META_DL *disclib;
+    unsigned toc_size;
+} DL_PARSE_CTX;
+
+static void _dl_element(xmlTextReaderPtr reader, const xmlChar *parent, const xmlChar *name, void *ctx)
+{
+    DL_PARSE_CTX *p = (DL_PARSE_CTX *)ctx;
+    META_DL *disclib = p->disclib;
+    xmlChar *tmp;
+
+    if (xmlStrEqual(parent, BAD_CAST_CONST "title")) {
+        if (xmlStrEqual(name, BAD_CAST_CONST "name")) {
+            XML_FREE(disclib->di_name);
+            disclib->di_name = _read_content(reader);
+        }
+        if (xmlStrEqual(name, BAD_CAST_CONST "alternative")) {
+            XML_FREE(disclib->di_alternative);
+            disclib->di_alternative = _read_content(reader);
+        }
+        if (xmlStrEqual(name, BAD_CAST_CONST "numSets")) {
+            disclib->di_num_sets = atoi((tmp = (xmlChar *)_read_content(reader)) ? (const char *)tmp : "");
+            XML_FREE(tmp);
+        }
+        if (xmlStrEqual(name, BAD_CAST_CONST "setNumber")) {
+            disclib->di_set_number = atoi((tmp = (xmlChar *)_read_content(reader)) ? (const char *)tmp : "");
+            XML_FREE(tmp);
+        }
+    }
+    else if (xmlStrEqual(parent, BAD_CAST_CONST "tableOfContents")) {
+        if (xmlStrEqual(name, BAD_CAST_CONST "titleName") && (tmp = xmlTextReaderGetAttribute(reader, BAD_CAST_CONST "titleNumber"))) {
+            if (disclib->toc_count >= p->toc_size) {
+                unsigned new_size = p->toc_size ? 2 * p->toc_size : 16;
+                META_TITLE *new_entries = realloc(disclib->toc_entries, new_size * sizeof(META_TITLE));
+                if (new_entries) {
+                    disclib->toc_entries = new_entries;
+                    p->toc_size = new_size;
                 }
             }
-            else if (xmlStrEqual(cur_node->parent->name, BAD_CAST_CONST "tableOfContents")) {
-                if (xmlStrEqual(cur_node->name, BAD_CAST_CONST "titleName") && (tmp = xmlGetProp(cur_node, BAD_CAST_CONST "titleNumber"))) {
-                    META_TITLE *new_entries = realloc(disclib->toc_entries, ((disclib->toc_count + 1)*sizeof(META_TITLE)));
-                    if (new_entries) {
-                        int i = disclib->toc_count;
-                        disclib->toc_count++;
-                        disclib->toc_entries = new_entries;
-                        disclib->toc_entries[i].title_number = atoi((const char*)tmp);
-                        disclib->toc_entries[i].title_name = (char*)xmlNodeGetContent(cur_node);
-                    }
+            if (disclib->toc_count < p->toc_size) {
+                uint32_t i = disclib->toc_count++;
+                disclib->toc_entries[i].title_number = atoi((const char*)tmp);
+                disclib->toc_entries[i].title_name = _read_content(reader);
+            }
+            XML_FREE(tmp);
+        }
+    }
+    else if (xmlStrEqual(parent, BAD_CAST_CONST "description")) {
+        if (xmlStrEqual(name, BAD_CAST_CONST "thumbnail") && disclib->thumb_count < 255 &&
+            (tmp = xmlTextReaderGetAttribute(reader, BAD_CAST_CONST "href"))) {
+            META_THUMBNAIL *new_thumbnails = realloc(disclib->thumbnails, ((disclib->thumb_count + 1)*sizeof(META_THUMBNAIL)));
+            if (new_thumbnails) {
+                uint8_t i = disclib->thumb_count;
+                disclib->thumb_count++;
+                disclib->thumbnails = new_thumbnails;
+                disclib->thumbnails[i].path = (char *)tmp;
+                if ((tmp = xmlTextReaderGetAttribute(reader, BAD_CAST_CONST "size"))) {
+                    int x = 0, y = 0;
+                    sscanf((const char*)tmp, "%ix%i", &x, &y);
+                    disclib->thumbnails[i].xres = x;
+                    disclib->thumbnails[i].yres = y;
                     XML_FREE(tmp);
                 }
-            }
-            else if (xmlStrEqual(cur_node->parent->name, BAD_CAST_CONST "description")) {
-                if (xmlStrEqual(cur_node->name, BAD_CAST_CONST "thumbnail") && (tmp = xmlGetProp(cur_node, BAD_CAST_CONST "href"))) {
-                    META_THUMBNAIL *new_thumbnails = realloc(disclib->thumbnails, ((disclib->thumb_count + 1)*sizeof(META_THUMBNAIL)));
-                    if (new_thumbnails) {
-                        uint8_t i = disclib->thumb_count;
-                        disclib->thumb_count++;
-                        disclib->thumbnails = new_thumbnails;
-                        disclib->thumbnails[i].path = (char *)tmp;
-                        if ((tmp = xmlGetProp(cur_node, BAD_CAST_CONST "size"))) {
-                            int x = 0, y = 0;
-                            sscanf((const char*)tmp, "%ix%i", &x, &y);
-                            disclib->thumbnails[i].xres = x;
-                            disclib->thumbnails[i].yres = y;
-                            XML_FREE(tmp);
-                        }
-                        else {
-                          disclib->thumbnails[i].xres = disclib->thumbnails[i].yres = -1;
-                        }
-                    }
+                else {
+                  disclib->thumbnails[i].xres = disclib->thumbnails[i].yres = -1;
                 }
+            } else {
+                XML_FREE(tmp);
             }
         }
-        _parseManifestNode(cur_node->children, disclib);
     }
 }
 
-static void _parseTnManifestNode(xmlNode * a_node, META_TN *disclib)
+static void _load_dl(META_ROOT *root, META_DL_ENTRY *e)
 {
-    xmlNode *cur_node = NULL;
-
-    for (cur_node = a_node; cur_node; cur_node = cur_node->next) {
-        if (cur_node->type == XML_ELEMENT_NODE) {
-            if (xmlStrEqual(cur_node->parent->name, BAD_CAST_CONST "chapters")) {
-                if (xmlStrEqual(cur_node->name, BAD_CAST_CONST "name")) {
-                    char **new_entries = realloc(disclib->chapter_name, ((disclib->num_chapter + 1)*sizeof(char *)));
-                    if (new_entries) {
-                        int i = disclib->num_chapter;
-                        disclib->num_chapter++;
-                        disclib->chapter_name = new_entries;
-                        disclib->chapter_name[i] = (char*)xmlNodeGetContent(cur_node);
-                    }
+    DL_PARSE_CTX ctx;
+
+    if (e->parsed) {
+        return;
+    }
+    e->parsed = 1;
+
+    e->dl.di_num_sets = e->dl.di_set_number = -1;
+
+    ctx.disclib  = &e->dl;
+    ctx.toc_size = 0;
+    _parse_xml(root->disc, META_DL_DIR, e->dl.filename, _dl_element, &ctx);
+}
+
+/*
+ * title (TN) files
+ */
+
+typedef struct {
+    META_TN  *tn;
+    unsigned  size;
+} TN_PARSE_CTX;
+
+static void _tn_element(xmlTextReaderPtr reader, const xmlChar *parent, const xmlChar *name, void *ctx)
+{
+    TN_PARSE_CTX *p = (TN_PARSE_CTX *)ctx;
+    META_TN *disclib = p->tn;
+
+    if (xmlStrEqual(parent, BAD_CAST_CONST "chapters")) {
+        if (xmlStrEqual(name, BAD_CAST_CONST "name")) {
+            if (disclib->num_chapter >= p->size) {
+                unsigned new_size = p->size ? 2 * p->size : 32;
+                char **new_entries = realloc(disclib->chapter_name, new_size * sizeof(char *));
+                if (new_entries) {
+                    disclib->chapter_name = new_entries;
+                    p->size = new_size;
                 }
             }
+            if (disclib->num_chapter < p->size) {
+                disclib->chapter_name[disclib->num_chapter++] = _read_content(reader);
+            }
         }
-        _parseTnManifestNode(cur_node->children, disclib);
     }
 }
 
+static void _load_tn(META_ROOT *root, META_TN_ENTRY *e)
+{
+    TN_PARSE_CTX ctx;
+
+    if (e->parsed) {
+        return;
+    }
+    e->parsed = 1;
+
+    ctx.tn   = &e->tn;
+    ctx.size = 0;
+    _parse_xml(root->disc, META_TN_DIR, e->tn.filename, _tn_element, &ctx);
+}
+
+/*
+ * file listing
+ */
+
 static void _findMetaXMLfiles(META_ROOT *meta, BD_DISC *disc)
 {
     BD_DIR_H *dir;
     BD_DIRENT ent;
+    unsigned  size;
     int res;
 
-    dir = disc_open_dir(disc, "BDMV" DIR_SEP "META" DIR_SEP "DL");
+    dir = disc_open_dir(disc, META_DL_DIR);
     if (dir == NULL) {
         BD_DEBUG(DBG_DIR, "Failed to open meta dir BDMV/META/DL/\n");
     } else {
+        size = 0;
+        for (res = dir_read(dir, &ent); !res; res = dir_read(dir, &ent)) {
+            if (ent.d_name[0] == '.')
+                continue;
+            else if (strncasecmp(ent.d_name, "bdmt_", 5) == 0 && strlen(ent.d_name) == 12 && meta->dl_count < 255) {
+                META_DL *dl;
+                if (meta->dl_count >= size) {
+                    unsigned new_size = size ? 2 * size : 8;
+                    META_DL_ENTRY *new_dl_entries = realloc(meta->dl_entries, new_size * sizeof(META_DL_ENTRY));
+                    if (!new_dl_entries) {
+                        break;
+                    }
+                    meta->dl_entries = new_dl_entries;
+                    size = new_size;
+                }
+                memset(&meta->dl_entries[meta->dl_count], 0, sizeof(META_DL_ENTRY));
+                dl = &meta->dl_entries[meta->dl_count].dl;
 
-    for (res = dir_read(dir, &ent); !res; res = dir_read(dir, &ent)) {
-        if (ent.d_name[0] == '.')
-            continue;
-        else if (strncasecmp(ent.d_name, "bdmt_", 5) == 0 && strlen(ent.d_name) == 12) {
-            META_DL *new_dl_entries = realloc(meta->dl_entries, ((meta->dl_count + 1)*sizeof(META_DL)));
-            if (new_dl_entries) {
-                uint8_t i = meta->dl_count;
+                dl->filename = str_dup(ent.d_name);
+                if (!dl->filename) {
+                    continue;
+                }
+                memcpy(dl->language_code, ent.d_name+5,3);
+                dl->language_code[3] = '\0';
+                str_tolower(dl->language_code);
                 meta->dl_count++;
-                meta->dl_entries = new_dl_entries;
-                memset(&meta->dl_entries[i], 0, sizeof(meta->dl_entries[i]));
-
-                meta->dl_entries[i].filename = str_dup(ent.d_name);
-                memcpy(meta->dl_entries[i].language_code, ent.d_name+5,3);
-                meta->dl_entries[i].language_code[3] = '\0';
-                str_tolower(meta->dl_entries[i].language_code);
             }
         }
-    }
-    dir_close(dir);
+        dir_close(dir);
     }
 
-    dir = disc_open_dir(disc, "BDMV" DIR_SEP "META" DIR_SEP "TN");
+    dir = disc_open_dir(disc, META_TN_DIR);
     if (dir == NULL) {
         BD_DEBUG(DBG_DIR, "Failed to open meta dir BDMV/META/TN/\n");
     } else {
+        size = 0;
         for (res = dir_read(dir, &ent); !res; res = dir_read(dir, &ent)) {
             if (strncasecmp(ent.d_name, "tnmt_", 5) == 0 && strlen(ent.d_name) == 18 ) {
-                META_TN *new_tn_entries = realloc(meta->tn_entries, ((meta->tn_count + 1)*sizeof(META_TN)));
-                if (new_tn_entries) {
-                    uint8_t i = meta->tn_count;
-                    meta->tn_count++;
+                META_TN *tn;
+                if (meta->tn_count >= size) {
+                    unsigned new_size = size ? 2 * size : 32;
+                    META_TN_ENTRY *new_tn_entries = realloc(meta->tn_entries, new_size * sizeof(META_TN_ENTRY));
+                    if (!new_tn_entries) {
+                        break;
+                    }
                     meta->tn_entries = new_tn_entries;
-                    memset(&meta->tn_entries[i], 0, sizeof(meta->tn_entries[i]));
+                    size = new_size;
+                }
+                memset(&meta->tn_entries[meta->tn_count], 0, sizeof(META_TN_ENTRY));
+                tn = &meta->tn_entries[meta->tn_count].tn;
 
-                    meta->tn_entries[i].filename = str_dup(ent.d_name);
-                    memcpy(meta->tn_entries[i].language_code, ent.d_name + 5, 3);
-                    meta->tn_entries[i].playlist = atoi(ent.d_name + 9);
-                    meta->tn_entries[i].language_code[3] = '\0';
-                    str_tolower(meta->tn_entries[i].language_code);
+                tn->filename = str_dup(ent.d_name);
+                if (!tn->filename) {
+                    continue;
                 }
+                memcpy(tn->language_code, ent.d_name + 5, 3);
+                tn->playlist = atoi(ent.d_name + 9);
+                tn->language_code[3] = '\0';
+                str_tolower(tn->language_code);
+                meta->tn_count++;
             }
         }
         dir_close(dir);
@@ -213,68 +373,17 @@ META_ROOT *meta_parse(BD_DISC *disc)
 {
 #ifdef HAVE_LIBXML2
     META_ROOT *root = calloc(1, sizeof(META_ROOT));
-    unsigned i;
 
     if (!root) {
         BD_DEBUG(DBG_CRIT, "out of memory\n");
         return NULL;
     }
-    root->dl_count = 0;
 
-    _findMetaXMLfiles(root, disc);
+    root->disc = disc;
 
-    for (i = 0; i < root->dl_count; i++) {
-        uint8_t *data = NULL;
-        size_t size;
-        size = disc_read_file(disc, "BDMV" DIR_SEP "META" DIR_SEP "DL",
-                              root->dl_entries[i].filename,
-                              &data);
-        if (!data || size == 0) {
-            BD_DEBUG(DBG_DIR, "Failed to read BDMV/META/DL/%s\n", root->dl_entries[i].filename);
-        } else {
-            xmlDocPtr doc;
-                doc = xmlReadMemory((char*)data, (int)size, NULL, NULL, 0);
-                if (doc == NULL) {
-                    BD_DEBUG(DBG_DIR, "Failed to parse BDMV/META/DL/%s\n", root->dl_entries[i].filename);
-                } else {
-                    xmlNode *root_element = NULL;
-                    root_element = xmlDocGetRootElement(doc);
-                    root->dl_entries[i].di_name = root->dl_entries[i].di_alternative = NULL;
-                    root->dl_entries[i].di_num_sets = root->dl_entries[i].di_set_number = -1;
-                    root->dl_entries[i].toc_count = root->dl_entries[i].thumb_count = 0;
-                    root->dl_entries[i].toc_entries = NULL;
-                    root->dl_entries[i].thumbnails = NULL;
-                    _parseManifestNode(root_element, &root->dl_entries[i]);
-                    xmlFreeDoc(doc);
-                }
-            X_FREE(data);
-        }
-    }
-
-    for (i = 0; i < root->tn_count; i++) {
-        uint8_t *data = NULL;
-        size_t size;
-        size = disc_read_file(disc, "BDMV" DIR_SEP "META" DIR_SEP "TN",
-                              root->tn_entries[i].filename,
-                              &data);
-        if (!data || size == 0) {
-            BD_DEBUG(DBG_DIR, "Failed to read BDMV/META/TN/%s\n", root->tn_entries[i].filename);
-        } else {
-            xmlDocPtr doc;
-                doc = xmlReadMemory((char*)data, (int)size, NULL, NULL, 0);
-                if (doc == NULL) {
-                    BD_DEBUG(DBG_DIR, "Failed to parse BDMV/META/TN/%s\n", root->tn_entries[i].filename);
-                } else {
-                    xmlNode *root_element = NULL;
-                    root_element = xmlDocGetRootElement(doc);
-                    _parseTnManifestNode(root_element, &root->tn_entries[i]);
-                    xmlFreeDoc(doc);
-                }
-            X_FREE(data);
-        }
-    }
+    /* files are parsed on demand */
+    _findMetaXMLfiles(root, disc);
 
-    xmlCleanupParser();
     return root;
 #else
     (void)disc;
@@ -283,19 +392,14 @@ META_ROOT *meta_parse(BD_DISC *disc)
 #endif
 }
 
-const META_DL *meta_get(const META_ROOT *meta_root, const char *language_code)
-{
 #ifdef HAVE_LIBXML2
+static META_DL_ENTRY *_find_dl(META_ROOT *meta_root, const char *language_code)
+{
     unsigned i;
 
-    if (meta_root == NULL || meta_root->dl_count == 0) {
-        BD_DEBUG(DBG_DIR, "meta_get not possible, no info available!\n");
-        return NULL;
-    }
-
     if (language_code) {
         for (i = 0; i < meta_root->dl_count; i++) {
-            if (strcmp(language_code, meta_root->dl_entries[i].language_code) == 0) {
+            if (strcmp(language_code, meta_root->dl_entries[i].dl.language_code) == 0) {
                 return &meta_root->dl_entries[i];
             }
         }
@@ -303,14 +407,30 @@ const META_DL *meta_get(const META_ROOT *meta_root, const char *language_code)
     }
 
     for (i = 0; i < meta_root->dl_count; i++) {
-        if (strcmp(DEFAULT_LANGUAGE, meta_root->dl_entries[i].language_code) == 0) {
+        if (strcmp(DEFAULT_LANGUAGE, meta_root->dl_entries[i].dl.language_code) == 0) {
             BD_DEBUG(DBG_DIR, "using default disclib language '"DEFAULT_LANGUAGE"'\n");
             return &meta_root->dl_entries[i];
         }
     }
 
-    BD_DEBUG(DBG_DIR, "requested disclib language '%s' or default '"DEFAULT_LANGUAGE"' not found, using '%s' instead\n", language_code, meta_root->dl_entries[0].language_code);
+    BD_DEBUG(DBG_DIR, "requested disclib language '%s' or default '"DEFAULT_LANGUAGE"' not found, using '%s' instead\n", language_code, meta_root->dl_entries[0].dl.language_code);
     return &meta_root->dl_entries[0];
+}
+#endif
+
+const META_DL *meta_get(META_ROOT *meta_root, const char *language_code)
+{
+#ifdef HAVE_LIBXML2
+    META_DL_ENTRY *e;
+
+    if (meta_root == NULL || meta_root->dl_count == 0) {
+        BD_DEBUG(DBG_DIR, "meta_get not possible, no info available!\n");
+        return NULL;
+    }
+
+    e = _find_dl(meta_root, language_code);
+    _load_dl(meta_root, e);
+    return &e->dl;
 #else
     (void)meta_root;
     (void)language_code;
@@ -318,38 +438,42 @@ const META_DL *meta_get(const META_ROOT *meta_root, const char *language_code)
 #endif
 }
 
-const META_TN *meta_get_tn(const META_ROOT *meta_root, const char *language_code, unsigned playlist)
+const META_TN *meta_get_tn(META_ROOT *meta_root, const char *language_code, unsigned playlist)
 {
 #ifdef HAVE_LIBXML2
     unsigned i;
-    META_TN *tn_default = NULL, *tn_first = NULL;
+    META_TN_ENTRY *tn_default = NULL, *tn_first = NULL;
 
     if (meta_root == NULL || meta_root->tn_count == 0) {
         return NULL;
     }
 
     for (i = 0; i < meta_root->tn_count; i++) {
-        if (meta_root->tn_entries[i].playlist == playlist) {
-            if (language_code && strcmp(language_code, meta_root->tn_entries[i].language_code) == 0) {
-                return &meta_root->tn_entries[i];
+        META_TN_ENTRY *e = &meta_root->tn_entries[i];
+        if (e->tn.playlist == playlist) {
+            if (language_code && strcmp(language_code, e->tn.language_code) == 0) {
+                _load_tn(meta_root, e);
+                return &e->tn;
             }
-            if (strcmp(DEFAULT_LANGUAGE, meta_root->tn_entries[i].language_code) == 0) {
-                tn_default = &meta_root->tn_entries[i];
+            if (strcmp(DEFAULT_LANGUAGE, e->tn.language_code) == 0) {
+                tn_default = e;
             }
             if (!tn_first) {
-                tn_first = &meta_root->tn_entries[i];
+                tn_first = e;
             }
         }
     }
 
     if (tn_default) {
         BD_DEBUG(DBG_DIR, "Requested disclib language '%s' not found, using default language '" DEFAULT_LANGUAGE "'\n", language_code);
-        return tn_default;
+        _load_tn(meta_root, tn_default);
+        return &tn_default->tn;
     }
     if (tn_first) {
         BD_DEBUG(DBG_DIR, "Requested disclib language '%s' or default '" DEFAULT_LANGUAGE "' not found, using '%s' instead\n",
-                 language_code, tn_first->language_code);
-        return tn_first;
+                 language_code, tn_first->tn.language_code);
+        _load_tn(meta_root, tn_first);
+        return &tn_first->tn;
     }
     return NULL;
 #else
@@ -366,30 +490,32 @@ void meta_free(META_ROOT **p)
 #ifdef HAVE_LIBXML2
     if (p && *p)
     {
-        uint8_t i;
+        unsigned i;
         for (i = 0; i < (*p)->dl_count; i++) {
+            META_DL *dl = &(*p)->dl_entries[i].dl;
             uint32_t t;
-            for (t = 0; t < (*p)->dl_entries[i].toc_count; t++) {
-                XML_FREE((*p)->dl_entries[i].toc_entries[t].title_name);
+            for (t = 0; t < dl->toc_count; t++) {
+                XML_FREE(dl->toc_entries[t].title_name);
             }
-            for (t = 0; t < (*p)->dl_entries[i].thumb_count; t++) {
-                XML_FREE((*p)->dl_entries[i].thumbnails[t].path);
+            for (t = 0; t < dl->thumb_count; t++) {
+                XML_FREE(dl->thumbnails[t].path);
             }
-            X_FREE((*p)->dl_entries[i].toc_entries);
-            X_FREE((*p)->dl_entries[i].thumbnails);
-            X_FREE((*p)->dl_entries[i].filename);
-            XML_FREE((*p)->dl_entries[i].di_name);
-            XML_FREE((*p)->dl_entries[i].di_alternative);
+            X_FREE(dl->toc_entries);
+            X_FREE(dl->thumbnails);
+            X_FREE(dl->filename);
+            XML_FREE(dl->di_name);
+            XML_FREE(dl->di_alternative);
         }
         X_FREE((*p)->dl_entries);
 
         for (i = 0; i < (*p)->tn_count; i++) {
+            META_TN *tn = &(*p)->tn_entries[i].tn;
             uint32_t c;
-            for (c = 0; c < (*p)->tn_entries[i].num_chapter; c++) {
-                XML_FREE((*p)->tn_entries[i].chapter_name[c]);
+            for (c = 0; c < tn->num_chapter; c++) {
+                XML_FREE(tn->chapter_name[c]);
             }
-            X_FREE((*p)->tn_entries[i].chapter_name);
-            X_FREE((*p)->tn_entries[i].filename);
+            X_FREE(tn->chapter_name);
+            X_FREE(tn->filename);
         }
         X_FREE((*p)->tn_entries);
 
@@ -40,8 +40,8 @@ typedef struct meta_tn {
 
 BD_PRIVATE struct meta_root *     meta_parse(struct bd_disc *disc) BD_ATTR_MALLOC;
 BD_PRIVATE void                   meta_free (struct meta_root **index);
-BD_PRIVATE const struct meta_dl * meta_get  (const struct meta_root *meta_root, const char *language_code);
-BD_PRIVATE const struct meta_tn * meta_get_tn(const struct meta_root *meta_root, const char *language_code, unsigned playlist);
+BD_PRIVATE const struct meta_dl * meta_get  (struct meta_root *meta_root, const char *language_code);  /* parsed on first use */
+BD_PRIVATE const struct meta_tn * meta_get_tn(struct meta_root *meta_root, const char *language_code, unsigned playlist);
 
 #endif // _META_PARSE_H_
 
@@ -35,6 +35,7 @@
 #include "util/macro.h"
 #include "util/logging.h"
 #include "util/strutl.h"
+#include "util/trace.h"
 #include "file/file.h"
 
 #include <stdlib.h>
@@ -390,7 +391,7 @@ static int _pl_guess_main_title(const MPLS_PL *p1, const MPLS_PL *p2,
  * title list
  */
 
-NAV_TITLE_LIST* nav_get_title_list(BD_DISC *disc, uint32_t flags, uint32_t min_title_length)
+static NAV_TITLE_LIST* _nav_get_title_list(BD_DISC *disc, uint32_t flags, uint32_t min_title_length)
 {
     BD_DIR_H *dir;
     BD_DIRENT ent;
@@ -500,6 +501,14 @@ NAV_TITLE_LIST* nav_get_title_list(BD_DISC *disc, uint32_t flags, uint32_t min_t
     return title_list;
 }
 
+NAV_TITLE_LIST* nav_get_title_list(BD_DISC *disc, uint32_t flags, uint32_t min_title_length)
+{
+    int64_t trace = bd_trace_begin();
+    NAV_TITLE_LIST *title_list = _nav_get_title_list(disc, flags, min_title_length);
+    bd_trace_end(trace, "nav_get_title_list", NULL);
+    return title_list;
+}
+
 void nav_free_title_list(NAV_TITLE_LIST **title_list)
 {
     if (*title_list) {
@@ -728,7 +737,7 @@ void nav_title_close(NAV_TITLE **title)
     }
 }
 
-NAV_TITLE* nav_title_open(BD_DISC *disc, const char *playlist, unsigned angle)
+static NAV_TITLE* _nav_title_open(BD_DISC *disc, const char *playlist, unsigned angle)
 {
     NAV_TITLE *title = NULL;
     unsigned ii, ss;
@@ -826,6 +835,14 @@ NAV_TITLE* nav_title_open(BD_DISC *disc, const char *playlist, unsigned angle)
     return title;
 }
 
+NAV_TITLE* nav_title_open(BD_DISC *disc, const char *playlist, unsigned angle)
+{
+    int64_t trace = bd_trace_begin();
+    NAV_TITLE *title = _nav_title_open(disc, playlist, angle);
+    bd_trace_end(trace, "nav_title_open", playlist);
+    return title;
+}
+
 // Search for random access point closest to the requested packet
 // Packets are 192 byte TS packets
 const NAV_CLIP* nav_chapter_search(const NAV_TITLE *title, unsigned chapter,
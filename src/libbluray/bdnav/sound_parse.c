@@ -32,8 +32,11 @@
 #include "util/logging.h"
 #include "util/macro.h"
 
+#include <stdio.h>  // SEEK_SET
 #include <stdlib.h>
 
+#define SOUND_FILE "BDMV" DIR_SEP "AUXDATA" DIR_SEP "sound.bdmv"
+
 #define BCLK_SIG1  ('B' << 24 | 'C' << 16 | 'L' << 8 | 'K')
 
 static int _bclk_parse_header(BITSTREAM *bs, uint32_t *data_start, uint32_t *extension_data_start)
@@ -95,30 +98,37 @@ static int _sound_parse_index(BITSTREAM *bs, uint32_t *sound_data_index, SOUND_O
     return 1;
 }
 
-static int _sound_read_samples(BITSTREAM *bs, SOUND_OBJECT *obj)
+/* convert big-endian 16-bit samples to native byte order (in place) */
+static void _be16_to_native(uint16_t *samples, uint32_t num_samples)
 {
+    const uint8_t *p = (const uint8_t *)samples;
     uint32_t n;
-    uint32_t num_samples = obj->num_frames * obj->num_channels;
 
-    if (!num_samples) {
-        return 1;
+    for (n = 0; n < num_samples; n++) {
+        samples[n] = (uint16_t)((p[2*n] << 8) | p[2*n + 1]);
     }
+}
 
-    if (bs_avail(bs)/16 < num_samples) {
-        BD_DEBUG(DBG_HDMV|DBG_CRIT, "sound.bdmv: unexpected EOF\n");
-        return 0;
-    }
+static int _sound_read_samples(BD_FILE_H *fp, SOUND_OBJECT *obj)
+{
+    uint32_t num_samples = obj->num_frames * obj->num_channels;
+    size_t   size = (size_t)num_samples * sizeof(uint16_t);
 
-    obj->samples = calloc(num_samples, sizeof(uint16_t));
+    obj->samples = malloc(size);
     if (!obj->samples) {
         BD_DEBUG(DBG_CRIT, "out of memory\n");
         return 0;
     }
 
-    for (n = 0; n < num_samples; n++) {
-        obj->samples[n] = bs_read(bs, 16);
+    if (file_seek(fp, obj->data_offset, SEEK_SET) < 0 ||
+        file_read(fp, (uint8_t *)obj->samples, size) != size) {
+        BD_DEBUG(DBG_HDMV|DBG_CRIT, "sound.bdmv: read error\n");
+        X_FREE(obj->samples);
+        return 0;
     }
 
+    _be16_to_native(obj->samples, num_samples);
+
     return 1;
 }
 
@@ -193,19 +203,18 @@ static SOUND_DATA *_sound_parse(BD_FILE_H *fp)
         }
     }
 
-    /* read samples */
+    /* locate samples. Samples are loaded on demand (sound_get_samples()). */
 
     for (i = 0; i < data->num_sounds; i++) {
+        SOUND_OBJECT *obj = &data->sounds[i];
+        uint64_t end;
 
-        if (bs_seek_byte(&bs, data_start + data_offsets[i]) < 0) {
-            BD_DEBUG(DBG_NAV | DBG_CRIT, "error reading samples for sound %d\n", i);
-            data->sounds[i].num_frames = 0;
-            continue;
-        }
+        obj->data_offset = (uint64_t)data_start + data_offsets[i];
 
-        if (!_sound_read_samples(&bs, &data->sounds[i])) {
+        end = obj->data_offset + (uint64_t)obj->num_frames * obj->num_channels * sizeof(uint16_t);
+        if (end > (uint64_t)bs.end) {
             BD_DEBUG(DBG_NAV | DBG_CRIT, "error reading samples for sound %d\n", i);
-            goto error;
+            obj->num_frames = 0;
         }
     }
 
@@ -225,7 +234,7 @@ SOUND_DATA *sound_get(BD_DISC *disc)
 
     /* there's no no backup copy for sound.bdmv */
 
-    fp = disc_open_path(disc, "BDMV" DIR_SEP "AUXDATA" DIR_SEP "sound.bdmv");
+    fp = disc_open_path(disc, SOUND_FILE);
     if (!fp) {
         return NULL;
     }
@@ -234,3 +243,31 @@ SOUND_DATA *sound_get(BD_DISC *disc)
     file_close(fp);
     return p;
 }
+
+const uint16_t *sound_get_samples(BD_DISC *disc, SOUND_DATA *data, unsigned sound_id)
+{
+    SOUND_OBJECT *obj;
+    BD_FILE_H    *fp;
+
+    if (sound_id >= data->num_sounds) {
+        return NULL;
+    }
+
+    obj = &data->sounds[sound_id];
+    if (obj->samples || !obj->num_frames) {
+        /* cached or empty */
+        return obj->samples;
+    }
+
+    fp = disc_open_path(disc, SOUND_FILE);
+    if (!fp) {
+        return NULL;
+    }
+
+    if (!_sound_read_samples(fp, obj)) {
+        BD_DEBUG(DBG_NAV | DBG_CRIT, "error reading samples for sound %u\n", sound_id);
+    }
+
+    file_close(fp);
+    return obj->samples;
+}
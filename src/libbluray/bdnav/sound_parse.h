@@ -30,7 +30,9 @@ typedef struct {
   uint8_t    bits_per_sample;
 
   uint32_t   num_frames;
-  uint16_t  *samples;       /* LPCM, interleaved */
+  uint16_t  *samples;       /* LPCM, interleaved. NULL until loaded with sound_get_samples(). */
+
+  uint64_t   data_offset;   /* file offset of samples */
 } SOUND_OBJECT;
 
 typedef struct {
@@ -40,7 +42,8 @@ typedef struct {
 
 struct bd_disc;
 
-BD_PRIVATE SOUND_DATA* sound_get(struct bd_disc *disc);              /* parse sound.bdmv */
+BD_PRIVATE SOUND_DATA* sound_get(struct bd_disc *disc);              /* parse sound.bdmv index */
+BD_PRIVATE const uint16_t *sound_get_samples(struct bd_disc *disc, SOUND_DATA *data, unsigned sound_id); /* load (cached) */
 BD_PRIVATE void        sound_free(SOUND_DATA **sound);
 
 #endif // _SOUND_PARSE_H_
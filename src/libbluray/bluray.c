@@ -26,6 +26,7 @@
 #include "bluray-version.h"
 #include "bluray.h"
 #include "bluray_internal.h"
+#include "keyframe.h"
 #include "keys.h"
 #include "register.h"
 #include "util/array.h"
@@ -34,7 +35,12 @@
 #include "util/logging.h"
 #include "util/strutl.h"
 #include "util/mutex.h"
+#include "util/thread.h"
+#include "util/time.h"
+#include "util/trace.h"
 #include "bdnav/bdid_parse.h"
+#include "bdnav/clpi_data.h"
+#include "bdnav/clpi_parse.h"
 #include "bdnav/navigation.h"
 #include "bdnav/index_parse.h"
 #include "bdnav/meta_parse.h"
@@ -44,6 +50,7 @@
 #include "hdmv/hdmv_vm.h"
 #include "hdmv/mobj_parse.h"
 #include "decoders/graphics_controller.h"
+#include "decoders/graphics_processor.h"
 #include "decoders/hdmv_pids.h"
 #include "decoders/m2ts_filter.h"
 #include "decoders/overlay.h"
@@ -65,10 +72,21 @@ typedef enum {
     title_bdj,
 } BD_TITLE_TYPE;
 
+/* cached PSI sections */
+enum {
+    PSI_PAT = 0,
+    PSI_PMT,
+    PSI_SIT,
+    PSI_SLOTS
+};
+#define PSI_MAX_PKTS  4  /* max. packets in cached PSI section */
+#define PSI_PAT_PMT   ((1 << PSI_PAT) | (1 << PSI_PMT))
+
 typedef struct {
     /* current clip */
     const NAV_CLIP *clip;
     BD_FILE_H      *fp;
+    char           fp_name[11]; /* file name of fp (clip may change before closing fp) */
     uint64_t       clip_size;
     uint64_t       clip_block_pos;
     uint64_t       clip_pos;
@@ -87,8 +105,16 @@ typedef struct {
     uint8_t         eof_hit;
     uint8_t         encrypted_block_cnt;
     uint8_t         seek_flag;  /* used to fine-tune first read after seek */
+    uint8_t         prefetch_sent; /* next clip prefetch hint issued */
 
     M2TS_FILTER    *m2ts_filter;
+
+    /* latest PSI sections (PAT, PMT, SIT) of current clip */
+    uint8_t         psi_valid;    /* bit mask of PSI_* slots */
+    uint8_t         psi_pending;  /* slots to be inserted before next stream data */
+    uint8_t         psi_pkts[PSI_SLOTS];
+    int16_t         psi_missing[PSI_SLOTS]; /* section bytes not yet received (<= 0: not collecting) */
+    uint8_t         psi[PSI_SLOTS][PSI_MAX_PKTS * 192];
 } BD_STREAM;
 
 typedef struct {
@@ -106,6 +132,14 @@ struct bluray {
     BLURAY_DISC_INFO  disc_info;
     BLURAY_TITLE    **titles;  /* titles from disc index */
     META_ROOT        *meta;
+
+    /* staged disc open */
+    BLURAY_OPEN_TIMING open_timing;
+    uint8_t           disc_info_bdj;   /* deferred BD-J part of disc_info has been filled */
+    uint8_t           disc_info_meta;  /* title names have been filled */
+    uint8_t           trace_first_read; /* trace first bd_read() after playlist open */
+    uint8_t           first_play_hdmv; /* first play is valid HDMV object */
+    uint8_t           top_menu_hdmv;   /* top menu is valid HDMV object */
     NAV_TITLE_LIST   *title_list;
 
     /* current playlist */
@@ -131,6 +165,12 @@ struct bluray {
     uint64_t       next_mark_pos;
     int            next_mark;
 
+    /* trick play (bd_read_trickplay()) */
+    uint8_t        tp_active;    /* 1 if trick play position is valid */
+    int            tp_ep;        /* EP map entry of current I-picture */
+    uint32_t       tp_pkt;       /* start packet of current I-picture */
+    uint32_t       tp_end_pkt;   /* end packet of current I-picture */
+
     /* player state */
     BD_REGISTERS   *regs;            /* player registers */
     BD_EVENT_QUEUE *event_queue;     /* navigation mode event queue */
@@ -160,6 +200,12 @@ struct bluray {
     BD_UO_MASK           gc_uo_mask;      /* UO mask from current menu page */
     uint32_t             gc_status;
     uint8_t              decode_pg;
+    uint8_t              decode_thread;   /* decode IG/PG in background thread */
+    int                  overlay_palette; /* BLURAY_PALETTE_* */
+
+    /* PG display set entry points of current main path clip (for seeking) */
+    GP_INDEX             pg_index;
+    const NAV_CLIP      *pg_index_clip;
 
     /* TextST */
     uint32_t gc_wakeup_time;  /* stream timestamp of next subtitle */
@@ -602,10 +648,11 @@ static void _update_hdmv_uo_mask(BLURAY *bd)
  * clip access (BD_STREAM)
  */
 
-static void _close_m2ts(BD_STREAM *st)
+static void _close_m2ts(BLURAY *bd, BD_STREAM *st)
 {
     if (st->fp != NULL) {
-        file_close(st->fp);
+        /* keep handle open for re-use */
+        disc_close_stream(bd->disc, st->fp_name, st->fp);
         st->fp = NULL;
     }
 
@@ -614,19 +661,24 @@ static void _close_m2ts(BD_STREAM *st)
 
 static int _open_m2ts(BLURAY *bd, BD_STREAM *st)
 {
-    _close_m2ts(st);
+    _close_m2ts(bd, st);
 
     if (!st->clip) {
         return 0;
     }
 
     st->fp = disc_open_stream(bd->disc, st->clip->name);
+    strcpy(st->fp_name, st->clip->name);
 
     st->clip_size = 0;
     st->clip_pos = (uint64_t)st->clip->start_pkt * 192;
     st->clip_block_pos = (st->clip_pos / 6144) * 6144;
     st->eof_hit = 0;
     st->encrypted_block_cnt = 0;
+    st->prefetch_sent = 0;
+    st->psi_valid = 0;
+    st->psi_pending = 0;
+    memset(st->psi_missing, 0, sizeof(st->psi_missing));
 
     if (st->fp) {
         int64_t clip_size = file_size(st->fp);
@@ -634,7 +686,7 @@ static int _open_m2ts(BLURAY *bd, BD_STREAM *st)
 
             if (file_seek(st->fp, st->clip_block_pos, SEEK_SET) < 0) {
                 BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to seek clip %s!\n", st->clip->name);
-                _close_m2ts(st);
+                _close_m2ts(bd, st);
                 return 0;
             }
 
@@ -665,7 +717,7 @@ static int _open_m2ts(BLURAY *bd, BD_STREAM *st)
         }
 
         BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Clip %s empty!\n", st->clip->name);
-        _close_m2ts(st);
+        _close_m2ts(bd, st);
     }
 
     BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to open clip %s!\n", st->clip->name);
@@ -728,6 +780,159 @@ static int _skip_unit(BLURAY *bd, BD_STREAM *st)
     return 0;
 }
 
+/* offset of payload in TS packet (after TP_extra_header). 0 if no payload. */
+static int _ts_payload_offset(const uint8_t *pkt)
+{
+    const uint8_t *ts = pkt + 4;
+    int offset = 4;
+
+    if (ts[3] & 0x20) {
+        offset += 1 + ts[4];   /* adaptation field */
+    }
+    if (!(ts[3] & 0x10) || offset >= 188) {
+        return 0;
+    }
+    return offset;
+}
+
+static void _update_psi(BD_STREAM *st, const uint8_t *buf)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < 6144; ii += 192) {
+        const uint8_t *pkt = buf + ii;
+        int slot, offset;
+
+        switch (TS_PID(pkt)) {
+            case HDMV_PID_PAT: slot = PSI_PAT; break;
+            case HDMV_PID_PMT: slot = PSI_PMT; break;
+            case HDMV_PID_SIT: slot = PSI_SIT; break;
+            default: continue;
+        }
+
+        offset = _ts_payload_offset(pkt);
+        if (!offset) {
+            continue;
+        }
+
+        if (pkt[4 + 1] & 0x40) {
+            /* payload_unit_start_indicator: new section */
+            int start = offset + 1 + pkt[4 + offset];   /* skip pointer_field */
+            int section_size;
+
+            st->psi_valid &= ~(1 << slot);
+            st->psi_missing[slot] = 0;
+            if (start + 3 > 188) {
+                continue;
+            }
+            section_size = 3 + (((pkt[4 + start + 1] & 0x0f) << 8) | pkt[4 + start + 2]);
+            if (section_size - (188 - start) > (PSI_MAX_PKTS - 1) * (188 - 4)) {
+                /* too large to cache: stream is rewound to include PSI after seek */
+                BD_DEBUG(DBG_STREAM, "PSI section of pid 0x%04x too large to cache (%d bytes)\n", TS_PID(pkt), section_size);
+                continue;
+            }
+
+            memcpy(st->psi[slot], pkt, 192);
+            st->psi_pkts[slot]    = 1;
+            st->psi_missing[slot] = (int16_t)(section_size - (188 - start));
+
+        } else if (st->psi_missing[slot] > 0 && st->psi_pkts[slot] < PSI_MAX_PKTS) {
+            memcpy(st->psi[slot] + 192 * st->psi_pkts[slot], pkt, 192);
+            st->psi_pkts[slot]++;
+            st->psi_missing[slot] -= (int16_t)(188 - offset);
+
+        } else {
+            continue;
+        }
+
+        /* complete section ? */
+        if (st->psi_missing[slot] <= 0) {
+            st->psi_missing[slot] = 0;
+            st->psi_valid |= 1 << slot;
+        }
+    }
+}
+
+/* Check unit without side effects (no events, error counters not touched) */
+static int _unit_is_plain(const uint8_t *buf)
+{
+    unsigned ii;
+
+    if (buf[0] & 0xc0) {
+        /* copy permission indicator: may be encrypted */
+        return 0;
+    }
+    for (ii = 0; ii < 6144; ii += 192) {
+        if (buf[ii + 4] != 0x47) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* load PSI from clip start (when nothing has been read from the clip yet) */
+static void _load_psi(BD_STREAM *st, uint8_t *buf)
+{
+    if (file_seek(st->fp, 0, SEEK_SET) < 0 || file_read(st->fp, buf, 6144) != 6144) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_load_psi(): error reading %s\n", st->clip->name);
+    } else if (_unit_is_plain(buf)) {
+        _update_psi(st, buf);
+    }
+
+    if (file_seek(st->fp, st->clip_block_pos, SEEK_SET) < 0) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to seek clip %s!\n", st->clip->name);
+    }
+}
+
+/* copy pending PSI packets to output. Returns number of bytes copied.
+ * Sections that do not fit stay pending (in order) for the next call. */
+static int _output_psi(BD_STREAM *st, uint8_t *buf, int len)
+{
+    int out_len = 0;
+    int slot;
+
+    for (slot = 0; slot < PSI_SLOTS; slot++) {
+        if (st->psi_pending & (1 << slot)) {
+            int size = 192 * st->psi_pkts[slot];
+            if (size > len - out_len) {
+                break;
+            }
+            memcpy(buf + out_len, st->psi[slot], size);
+            out_len += size;
+            st->psi_pending &= ~(1 << slot);
+        }
+    }
+
+    return out_len;
+}
+
+/* insert pending PSI. Returns bytes copied, 0 if caller should return data read so far. */
+static int _insert_psi(BD_STREAM *st, uint8_t *buf, int len, int out_len)
+{
+    int psi_len = _output_psi(st, buf, len);
+
+    if (!psi_len && !out_len) {
+        /* buffer is too small for the section */
+        BD_DEBUG(DBG_STREAM | DBG_CRIT, "Read buffer too small for PSI (%d bytes), dropping it\n", len);
+        st->psi_pending = 0;
+    }
+    return psi_len;
+}
+
+/* Include packets preceding the seek point: PCR, and PAT/PMT/SIT when those are not inserted from cache. */
+static void _seek_rewind(BLURAY *bd, BD_STREAM *st, int psi_inserted)
+{
+    while (st->int_buf_off >= 192) {
+        uint16_t pid = TS_PID(bd->int_buf + st->int_buf_off - 192);
+        if (pid != HDMV_PID_PCR && (psi_inserted || pid > HDMV_PID_PCR)) {
+            break;
+        }
+        st->clip_pos -= 192;
+        st->int_buf_off -= 192;
+        bd->s_pos -= 192;
+    }
+}
+
 static int _read_block(BLURAY *bd, BD_STREAM *st, uint8_t *buf)
 {
     const size_t len = 6144;
@@ -738,7 +943,15 @@ static int _read_block(BLURAY *bd, BD_STREAM *st, uint8_t *buf)
         if (len + st->clip_block_pos <= st->clip_size) {
             size_t read_len;
 
-            if ((read_len = file_read(st->fp, buf, len))) {
+            /* positioned read can be served from completed read-ahead */
+            if (file_can_pread(st->fp)) {
+                int64_t got = file_pread(st->fp, buf, len, st->clip_block_pos);
+                read_len = got > 0 ? (size_t)got : 0;
+            } else {
+                read_len = (size_t)file_read(st->fp, buf, len);
+            }
+
+            if (read_len) {
                 int error;
 
                 if (read_len != len) {
@@ -754,6 +967,8 @@ static int _read_block(BLURAY *bd, BD_STREAM *st, uint8_t *buf)
                     return error;
                 }
 
+                _update_psi(st, buf);
+
                 if (st->m2ts_filter) {
                     int result = m2ts_filter(st->m2ts_filter, buf);
                     if (result < 0) {
@@ -798,6 +1013,25 @@ static int _read_block(BLURAY *bd, BD_STREAM *st, uint8_t *buf)
     return -1;
 }
 
+/*
+ * next clip prefetch
+ */
+
+#define PREFETCH_DISTANCE  (8*1024*1024)  /* issue hint when this close to clip end */
+#define PREFETCH_SIZE      (4*1024*1024)  /* size of prefetched range */
+
+static void _prefetch_next_clip(BLURAY *bd, BD_STREAM *st)
+{
+    const NAV_CLIP *next;
+
+    st->prefetch_sent = 1;
+
+    next = nav_next_clip(bd->title, st->clip);
+    if (next) {
+        disc_prefetch_stream(bd->disc, next->name, (int64_t)next->start_pkt * 192, PREFETCH_SIZE);
+    }
+}
+
 /*
  * clip preload (BD_PRELOAD)
  */
@@ -833,7 +1067,7 @@ static int _preload_m2ts(BLURAY *bd, BD_PRELOAD *p)
     uint8_t* tmp = (uint8_t*)realloc(p->buf, p->clip_size);
     if (!tmp) {
         BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_preload_m2ts(): out of memory\n");
-        _close_m2ts(&st);
+        _close_m2ts(bd, &st);
         _close_preload(p);
         return 0;
     }
@@ -849,7 +1083,7 @@ static int _preload_m2ts(BLURAY *bd, BD_PRELOAD *p)
         if (_read_block(bd, &st, buf) <= 0) {
             BD_DEBUG(DBG_BLURAY|DBG_CRIT, "_preload_m2ts(): error loading %s at %" PRIu64 "\n",
                   st.clip->name, (uint64_t)(buf - p->buf));
-            _close_m2ts(&st);
+            _close_m2ts(bd, &st);
             _close_preload(p);
             return 0;
         }
@@ -860,7 +1094,7 @@ static int _preload_m2ts(BLURAY *bd, BD_PRELOAD *p)
     BD_DEBUG(DBG_BLURAY, "_preload_m2ts(): loaded %" PRIu64 " bytes from %s\n",
           st.clip_size, st.clip->name);
 
-    _close_m2ts(&st);
+    _close_m2ts(bd, &st);
 
     return 1;
 }
@@ -893,9 +1127,81 @@ static int64_t _seek_stream(BLURAY *bd, BD_STREAM *st,
     st->int_buf_off = 6144;
     st->seek_flag = 1;
 
+    /* PAT/PMT/SIT are inserted from cache: no need to include the packets preceding seek point */
+    st->psi_pending = 0;
+    if ((st->psi_valid & PSI_PAT_PMT) == PSI_PAT_PMT) {
+        st->psi_pending = st->psi_valid;
+    }
+
     return st->clip_pos;
 }
 
+/*
+ * PG seeking
+ */
+
+#define PG_PREROLL_UNITS  128  /* max. PG units to re-read before seek point */
+
+/* remember display set entry points of main path PG stream */
+static void _update_pg_index(BLURAY *bd, BD_STREAM *st)
+{
+    if (bd->pg_index_clip != st->clip) {
+        graphics_processor_index_clear(&bd->pg_index);
+        bd->pg_index_clip = st->clip;
+    }
+
+    graphics_processor_index_scan(&bd->pg_index, st->pg_pid, bd->int_buf, 1, st->clip_block_pos - 6144);
+}
+
+/* Decode PG stream from previous entry point to seek point.
+ * Only units known to carry PG packets are re-read from the main path stream. */
+static void _preroll_pg(BLURAY *bd)
+{
+    BD_STREAM            *st = &bd->st0;
+    const GP_ENTRY_POINT *ep;
+    const uint64_t       *unit;
+    unsigned              num_units, ii;
+
+    if (!bd->decode_pg || !st->pg_pid || !st->clip || !st->fp ||
+        bd->pg_index_clip != st->clip || bd->pg_index.pid != st->pg_pid) {
+        return;
+    }
+
+    ep = graphics_processor_index_find(&bd->pg_index, st->clip_block_pos);
+    if (!ep || ep->pos >= st->clip_block_pos) {
+        return;
+    }
+
+    num_units = graphics_processor_index_units(&bd->pg_index, ep->pos, st->clip_block_pos, &unit);
+    if (num_units > PG_PREROLL_UNITS) {
+        BD_DEBUG(DBG_BLURAY, "_preroll_pg(): entry point too far (%u units)\n", num_units);
+        return;
+    }
+
+    /* main path buffer is refilled after seek */
+    for (ii = 0; ii < num_units; ii++) {
+        if (file_seek(st->fp, unit[ii], SEEK_SET) < 0 ||
+            file_read(st->fp, bd->int_buf, 6144) != 6144) {
+            BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_preroll_pg(): read failed\n");
+            break;
+        }
+        if (bd->int_buf[4] != 0x47) {
+            continue;
+        }
+        if (gc_decode_ts(bd->graphics_controller, st->pg_pid, bd->int_buf, 1, -1) > 0) {
+            gc_run(bd->graphics_controller, GC_CTRL_PG_UPDATE, 0, NULL);
+        }
+    }
+
+    /* restore stream position */
+    if (file_seek(st->fp, st->clip_block_pos, SEEK_SET) < 0) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to seek clip %s!\n", st->clip->name);
+    }
+
+    BD_DEBUG(DBG_BLURAY, "_preroll_pg(): decoded %u units from %s at %" PRId64 "\n",
+             ii, ep->epoch_start ? "epoch start" : "acquisition point", ep->pts);
+}
+
 /*
  * Graphics controller interface
  */
@@ -949,6 +1255,14 @@ static int _run_gc(BLURAY *bd, gc_ctrl_e msg, uint32_t param)
     return result;
 }
 
+/* initialize menus decoded in background thread */
+static void _poll_gc_menu(BLURAY *bd)
+{
+    if (bd->graphics_controller && gc_poll_menu_ready(bd->graphics_controller) > 0) {
+        _run_gc(bd, GC_CTRL_INIT_MENU, 0);
+    }
+}
+
 /*
  * disc info
  */
@@ -972,10 +1286,63 @@ static void _check_bdj(BLURAY *bd)
     }
 }
 
-static void _fill_disc_info(BLURAY *bd, BD_ENC_INFO *enc_info)
+static uint32_t _elapsed_ms(uint64_t t0)
+{
+    return (uint32_t)((bd_get_scr() - t0) / 90);
+}
+
+/* BD-J part of disc info. Deferred until first use, JVM probing may be slow. */
+static void _fill_disc_info_bdj(BLURAY *bd)
 {
-    INDX_ROOT *index = NULL;
+    uint64_t t0;
+
+    if (bd->disc_info_bdj) {
+        return;
+    }
+    bd->disc_info_bdj = 1;
+
+    t0 = bd_get_scr();
+
+    _check_bdj(bd);
 
+    if (bd->titles) {
+        BLURAY_TITLE *first_play = bd->titles[bd->disc_info.num_titles + 1];
+        BLURAY_TITLE *top_menu   = bd->titles[0];
+
+        /* mark supported titles */
+
+        if (bd->disc_info.bdj_detected && !bd->disc_info.bdj_handled) {
+            bd->disc_info.num_unsupported_titles = bd->disc_info.num_bdj_titles;
+        }
+
+        bd->disc_info.first_play_supported = first_play->bdj ? bd->disc_info.bdj_handled : bd->first_play_hdmv;
+        bd->disc_info.top_menu_supported   = top_menu->bdj   ? bd->disc_info.bdj_handled : bd->top_menu_hdmv;
+
+        if (bd->disc_info.first_play_supported) {
+            first_play->accessible = 1;
+            bd->disc_info.first_play = first_play;
+        }
+        if (bd->disc_info.top_menu_supported) {
+            top_menu->accessible = 1;
+            bd->disc_info.top_menu = top_menu;
+        }
+    }
+
+    if (bd->disc && bd->disc_info.bdj_detected) {
+        BDID_DATA *bdid = bdid_get(bd->disc); /* parse id.bdmv */
+        if (bdid) {
+            memcpy(bd->disc_info.bdj_org_id,  bdid->org_id,  sizeof(bd->disc_info.bdj_org_id));
+            memcpy(bd->disc_info.bdj_disc_id, bdid->disc_id, sizeof(bd->disc_info.bdj_disc_id));
+            bdid_free(&bdid);
+        }
+    }
+
+    bd->open_timing.bdj = _elapsed_ms(t0);
+}
+
+/* index is parsed by caller (may be NULL). Takes ownership of index. */
+static void _fill_disc_info(BLURAY *bd, BD_ENC_INFO *enc_info, INDX_ROOT *index)
+{
     if (enc_info) {
         bd->disc_info.aacs_detected      = enc_info->aacs_detected;
         bd->disc_info.libaacs_detected   = enc_info->libaacs_detected;
@@ -1011,9 +1378,13 @@ static void _fill_disc_info(BLURAY *bd, BD_ENC_INFO *enc_info)
     memset(bd->disc_info.bdj_org_id,  0, sizeof(bd->disc_info.bdj_org_id));
     memset(bd->disc_info.bdj_disc_id, 0, sizeof(bd->disc_info.bdj_disc_id));
 
+    bd->disc_info_bdj   = 0;
+    bd->disc_info_meta  = 0;
+    bd->first_play_hdmv = 0;
+    bd->top_menu_hdmv   = 0;
+
     if (bd->disc) {
         bd->disc_info.udf_volume_id = disc_volume_id(bd->disc);
-        index = indx_get(bd->disc);
         if (!index) {
             /* check for incomplete disc */
             NAV_TITLE_LIST *title_list = nav_get_title_list(bd->disc, 0, 0);
@@ -1079,6 +1450,7 @@ static void _fill_disc_info(BLURAY *bd, BD_ENC_INFO *enc_info)
             titles[index->num_titles + 1]->id_ref = atoi(pi->bdj.name);
         }
         if (pi->object_type == indx_object_type_hdmv && pi->hdmv.id_ref != 0xffff) {
+            bd->first_play_hdmv = 1;
             titles[index->num_titles + 1]->interactive = (pi->hdmv.playback_type == indx_hdmv_playback_type_interactive);
             titles[index->num_titles + 1]->id_ref = pi->hdmv.id_ref;
         }
@@ -1091,44 +1463,12 @@ static void _fill_disc_info(BLURAY *bd, BD_ENC_INFO *enc_info)
             titles[0]->id_ref = atoi(pi->bdj.name);
         }
         if (pi->object_type == indx_object_type_hdmv && pi->hdmv.id_ref != 0xffff) {
+            bd->top_menu_hdmv = 1;
             titles[0]->interactive = (pi->hdmv.playback_type == indx_hdmv_playback_type_interactive);
             titles[0]->id_ref = pi->hdmv.id_ref;
         }
 
-        /* mark supported titles */
-
-        _check_bdj(bd);
-
-        if (bd->disc_info.bdj_detected && !bd->disc_info.bdj_handled) {
-            bd->disc_info.num_unsupported_titles = bd->disc_info.num_bdj_titles;
-        }
-
-        pi = &index->first_play;
-        if (pi->object_type == indx_object_type_hdmv && pi->hdmv.id_ref != 0xffff) {
-            bd->disc_info.first_play_supported = 1;
-        }
-        if (pi->object_type == indx_object_type_bdj) {
-            bd->disc_info.first_play_supported = bd->disc_info.bdj_handled;
-        }
-
-        pi = &index->top_menu;
-        if (pi->object_type == indx_object_type_hdmv && pi->hdmv.id_ref != 0xffff) {
-            bd->disc_info.top_menu_supported = 1;
-        }
-        if (pi->object_type == indx_object_type_bdj) {
-            bd->disc_info.top_menu_supported = bd->disc_info.bdj_handled;
-        }
-
-        /* */
-
-        if (bd->disc_info.first_play_supported) {
-            titles[index->num_titles + 1]->accessible = 1;
-            bd->disc_info.first_play = titles[index->num_titles + 1];
-        }
-        if (bd->disc_info.top_menu_supported) {
-            titles[0]->accessible = 1;
-            bd->disc_info.top_menu = titles[0];
-        }
+        /* supported titles are marked in _fill_disc_info_bdj() */
 
         /* increase player profile and version when 3D or UHD disc is detected */
 
@@ -1147,8 +1487,7 @@ static void _fill_disc_info(BLURAY *bd, BD_ENC_INFO *enc_info)
 
         indx_free(&index);
 
-        /* populate title names */
-        bd_get_meta(bd);
+        /* title names (metadata) are populated in bd_get_disc_info() */
     }
 
 #if 0
@@ -1156,29 +1495,36 @@ static void _fill_disc_info(BLURAY *bd, BD_ENC_INFO *enc_info)
         bd->disc_info.no_menu_support = 1;
     }
 #endif
-
-    if (bd->disc_info.bdj_detected) {
-        BDID_DATA *bdid = bdid_get(bd->disc); /* parse id.bdmv */
-        if (bdid) {
-            memcpy(bd->disc_info.bdj_org_id,  bdid->org_id,  sizeof(bd->disc_info.bdj_org_id));
-            memcpy(bd->disc_info.bdj_disc_id, bdid->disc_id, sizeof(bd->disc_info.bdj_disc_id));
-            bdid_free(&bdid);
-        }
-    }
-
-    _check_bdj(bd);
 }
 
 const BLURAY_DISC_INFO *bd_get_disc_info(BLURAY *bd)
 {
     bd_mutex_lock(&bd->mutex);
     if (!bd->disc) {
-        _fill_disc_info(bd, NULL);
+        _fill_disc_info(bd, NULL, NULL);
+    }
+
+    /* deferred stages */
+    _fill_disc_info_bdj(bd);
+    if (!bd->disc_info_meta && bd->titles) {
+        uint64_t t0 = bd_get_scr();
+        bd->disc_info_meta = 1;
+        bd_get_meta(bd);
+        bd->open_timing.meta = _elapsed_ms(t0);
     }
+
     bd_mutex_unlock(&bd->mutex);
     return &bd->disc_info;
 }
 
+const BLURAY_OPEN_TIMING *bd_get_open_timing(BLURAY *bd)
+{
+    if (!bd) {
+        return NULL;
+    }
+    return &bd->open_timing;
+}
+
 /*
  * bdj callbacks
  */
@@ -1490,11 +1836,31 @@ BLURAY *bd_init(void)
     return bd;
 }
 
+typedef struct {
+    BD_DISC   *disc;
+    INDX_ROOT *index;
+    uint32_t   ms;
+} INDX_JOB;
+
+static void _indx_job(void *p)
+{
+    INDX_JOB *job = (INDX_JOB *)p;
+    uint64_t  t0  = bd_get_scr();
+
+    job->index = indx_get(job->disc);
+    job->ms    = _elapsed_ms(t0);
+}
+
 static int _bd_open(BLURAY *bd,
                     const char *device_path, const char *keyfile_path,
                     fs_access *p_fs)
 {
     BD_ENC_INFO enc_info;
+    BD_THREAD   thread;
+    INDX_JOB    job;
+    uint64_t    t0, t1;
+    int64_t     trace;
+    int         threaded;
 
     if (!bd) {
         return 0;
@@ -1508,16 +1874,44 @@ static int _bd_open(BLURAY *bd,
         return 0;
     }
 
-    bd->disc = disc_open(device_path, p_fs,
-                         &enc_info, keyfile_path,
-                         (void*)bd->regs, (void*)bd_psr_read, (void*)bd_psr_write);
+    memset(&bd->open_timing, 0, sizeof(bd->open_timing));
+    t0 = bd_get_scr();
+    trace = bd_trace_begin();
 
+    bd->disc = disc_open_fs(device_path, p_fs);
     if (!bd->disc) {
         bd_mutex_unlock(&bd->mutex);
         return 0;
     }
 
-    _fill_disc_info(bd, &enc_info);
+    bd->open_timing.filesystem = _elapsed_ms(t0);
+
+    /* parse disc index while decryption is initialized */
+    job.disc  = bd->disc;
+    job.index = NULL;
+    job.ms    = 0;
+    threaded = !bd_thread_create(&thread, _indx_job, &job);
+
+    t1 = bd_get_scr();
+    disc_open_dec(bd->disc, &enc_info, keyfile_path,
+                  (void*)bd->regs, (void*)bd_psr_read, (void*)bd_psr_write);
+    bd->open_timing.decryption = _elapsed_ms(t1);
+
+    if (threaded) {
+        bd_thread_join(&thread);
+    } else {
+        _indx_job(&job);
+    }
+    bd->open_timing.index = job.ms;
+
+    _fill_disc_info(bd, &enc_info, job.index);
+
+    bd->open_timing.total = _elapsed_ms(t0);
+    bd_trace_end(trace, "bd_open", device_path);
+
+    BD_DEBUG(DBG_BLURAY, "Disc opened in %u ms (file system %u ms, decryption %u ms, index %u ms)\n",
+             bd->open_timing.total, bd->open_timing.filesystem,
+             bd->open_timing.decryption, bd->open_timing.index);
 
     bd_mutex_unlock(&bd->mutex);
 
@@ -1584,10 +1978,13 @@ void bd_close(BLURAY *bd)
 
     _close_bdj(bd);
 
-    _close_m2ts(&bd->st0);
+    _close_m2ts(bd, &bd->st0);
     _close_preload(&bd->st_ig);
     _close_preload(&bd->st_textst);
 
+    graphics_processor_index_clear(&bd->pg_index);
+    bd->pg_index_clip = NULL;
+
     nav_free_title_list(&bd->title_list);
     nav_title_close(&bd->title);
 
@@ -1665,6 +2062,8 @@ static void _playmark_reached(BLURAY *bd)
 static void _seek_internal(BLURAY *bd,
                            const NAV_CLIP *clip, uint32_t title_pkt, uint32_t clip_pkt)
 {
+    bd->tp_active = 0;
+
     if (_seek_stream(bd, &bd->st0, clip, clip_pkt) >= 0) {
         uint32_t media_time;
 
@@ -1688,6 +2087,9 @@ static void _seek_internal(BLURAY *bd,
         if (bd->graphics_controller) {
             gc_run(bd->graphics_controller, GC_CTRL_PG_RESET, 0, NULL);
 
+            /* show subtitles already active at seek point */
+            _preroll_pg(bd);
+
             _init_textst_timer(bd);
         }
 
@@ -1704,7 +2106,7 @@ static void _change_angle(BLURAY *bd)
         bd_psr_write(bd->regs, PSR_ANGLE_NUMBER, bd->title->angle + 1);
 
         /* force re-opening .m2ts file in _seek_internal() */
-        _close_m2ts(&bd->st0);
+        _close_m2ts(bd, &bd->st0);
     }
 }
 
@@ -2043,17 +2445,24 @@ static int _bd_read(BLURAY *bd, unsigned char *buf, int len)
                 int r = _read_block(bd, st, bd->int_buf);
                 if (r > 0) {
 
+                    /* warm up next clip before reaching play item boundary */
+                    if (!st->prefetch_sent &&
+                        st->clip_block_pos + PREFETCH_DISTANCE >= (uint64_t)st->clip->end_pkt * 192) {
+                        _prefetch_next_clip(bd, st);
+                    }
+
                     if (st->ig_pid > 0) {
-                        if (gc_decode_ts(bd->graphics_controller, st->ig_pid, bd->int_buf, 1, -1) > 0) {
+                        if (gc_queue_ts(bd->graphics_controller, st->ig_pid, bd->int_buf, 1) > 0) {
                             /* initialize menus */
                             _run_gc(bd, GC_CTRL_INIT_MENU, 0);
                         }
                     }
+                    _poll_gc_menu(bd);
                     if (st->pg_pid > 0) {
-                        if (gc_decode_ts(bd->graphics_controller, st->pg_pid, bd->int_buf, 1, -1) > 0) {
-                            /* render subtitles */
-                            gc_run(bd->graphics_controller, GC_CTRL_PG_UPDATE, 0, NULL);
-                        }
+                        _update_pg_index(bd, st);
+
+                        /* decode and render subtitles */
+                        gc_queue_ts(bd->graphics_controller, st->pg_pid, bd->int_buf, 1);
                     }
                     if (bd->st_textst.clip) {
                         _update_textst_timer(bd);
@@ -2073,15 +2482,22 @@ static int _bd_read(BLURAY *bd, unsigned char *buf, int len)
                 if (BD_UNLIKELY(st->seek_flag)) {
                     st->seek_flag = 0;
 
-                    /* rewind if previous packets contain PAT/PMT/PCR */
-                    while (st->int_buf_off >= 192 && TS_PID(bd->int_buf + st->int_buf_off - 192) <= HDMV_PID_PCR) {
-                        st->clip_pos -= 192;
-                        st->int_buf_off -= 192;
-                        bd->s_pos -= 192;
-                    }
+                    _seek_rewind(bd, st, st->psi_pending != 0);
                 }
 
             }
+
+            /* insert cached PAT/PMT/SIT after seek */
+            if (BD_UNLIKELY(st->psi_pending)) {
+                int psi_len = _insert_psi(st, buf, len, out_len);
+                if (!psi_len && st->psi_pending) {
+                    return out_len;
+                }
+                buf += psi_len;
+                len -= psi_len;
+                out_len += psi_len;
+                continue;
+            }
             if (size > (unsigned int)6144 - st->int_buf_off) {
                 size = 6144 - st->int_buf_off;
             }
@@ -2125,6 +2541,11 @@ static int _bd_read_locked(BLURAY *bd, unsigned char *buf, int len)
         return 0;
     }
 
+    /* continue normal playback from the last trick play I-picture */
+    if (bd->tp_active) {
+        _seek_internal(bd, st->clip, st->clip->title_pkt + bd->tp_pkt - st->clip->start_pkt, bd->tp_pkt);
+    }
+
     BD_DEBUG(DBG_STREAM, "Reading [%d bytes] at %" PRIu64 "...\n", len, bd->s_pos);
 
     r = _bd_read(bd, buf, len);
@@ -2142,7 +2563,14 @@ int bd_read(BLURAY *bd, unsigned char *buf, int len)
     int result;
 
     bd_mutex_lock(&bd->mutex);
-    result = _bd_read_locked(bd, buf, len);
+    if (bd->trace_first_read) {
+        int64_t trace = bd_trace_begin();
+        result = _bd_read_locked(bd, buf, len);
+        bd_trace_end(trace, "bd_read (first)", NULL);
+        bd->trace_first_read = 0;
+    } else {
+        result = _bd_read_locked(bd, buf, len);
+    }
     bd_mutex_unlock(&bd->mutex);
 
     return result;
@@ -2169,6 +2597,337 @@ int bd_read_skip_still(BLURAY *bd)
     return ret;
 }
 
+/*
+ * trick play
+ */
+
+static uint64_t _title_pos(const NAV_CLIP *clip, uint32_t clip_pkt)
+{
+    return ((uint64_t)clip->title_pkt + clip_pkt - clip->start_pkt) * 192;
+}
+
+/* range of EP map entries inside play item */
+static int _clip_ep_range(const NAV_CLIP *clip, int *first, int *last)
+{
+    if (clpi_ep_count(clip->cl) < 1) {
+        return 0;
+    }
+
+    *first = clpi_ep_find(clip->cl, clip->start_pkt);
+    if (*first < 0 || clpi_ep_entry(clip->cl, *first, NULL, NULL) < clip->start_pkt) {
+        (*first)++;
+    }
+    *last = clpi_ep_find(clip->cl, clip->end_pkt - 1);
+
+    return *first <= *last;
+}
+
+static int _trickplay_next(BLURAY *bd, int stride)
+{
+    BD_STREAM *st = &bd->st0;
+    const NAV_CLIP *clip = st->clip;
+    int ep, first, last;
+    uint32_t time;
+
+    if (!bd->tp_active) {
+        /* start from the I-picture at (or before) current position */
+        ep = clpi_ep_find(clip->cl, SPN(st->clip_pos));
+        if (!_clip_ep_range(clip, &first, &last)) {
+            ep = stride > 0 ? INT32_MAX : -1;
+        } else if (ep < first) {
+            ep = first;
+        }
+    } else {
+        /* stride comes from application: avoid int overflow */
+        int64_t next = (int64_t)bd->tp_ep + stride;
+        ep = (int)BD_MAX(BD_MIN(next, INT32_MAX), INT32_MIN);
+    }
+
+    /* move to next / previous clip if needed */
+    while (!_clip_ep_range(clip, &first, &last) || ep < first || ep > last) {
+        if (stride > 0) {
+            clip = nav_next_clip(bd->title, clip);
+            if (!clip) {
+                BD_DEBUG(DBG_BLURAY | DBG_STREAM, "Trick play: end of title\n");
+                _queue_event(bd, BD_EVENT_END_OF_TITLE, 0);
+                return 0;
+            }
+            ep = INT32_MIN;
+            if (_clip_ep_range(clip, &first, &last)) {
+                ep = first;
+            }
+        } else {
+            if (clip->ref < 1) {
+                BD_DEBUG(DBG_BLURAY | DBG_STREAM, "Trick play: start of title\n");
+                return 0;
+            }
+            clip = &bd->title->clip_list.clip[clip->ref - 1];
+            ep = INT32_MAX;
+            if (_clip_ep_range(clip, &first, &last)) {
+                ep = last;
+            }
+        }
+    }
+
+    bd->tp_ep     = ep;
+    bd->tp_pkt    = clpi_ep_entry(clip->cl, ep, &bd->tp_end_pkt, &time);
+    bd->tp_active = 1;
+    if (bd->tp_end_pkt > clip->end_pkt) {
+        bd->tp_end_pkt = clip->end_pkt;
+    }
+
+    if (_seek_stream(bd, st, clip, bd->tp_pkt) < 0) {
+        return -1;
+    }
+    bd->s_pos = _title_pos(clip, bd->tp_pkt);
+
+    /* PAT and PMT are inserted before each I-picture */
+    if ((st->psi_valid & PSI_PAT_PMT) != PSI_PAT_PMT) {
+        _load_psi(st, bd->int_buf); /* int_buf is not in use: stream was just seeked */
+    }
+    st->psi_pending = st->psi_valid;
+
+    if (time >= clip->in_time && time <= clip->out_time) {
+        _update_time_psr(bd, time);
+    }
+
+    BD_DEBUG(DBG_STREAM, "Trick play: %s EP %d (packets %u-%u)\n",
+             clip->name, ep, bd->tp_pkt, bd->tp_end_pkt);
+
+    return 1;
+}
+
+static int _bd_read_trickplay(BLURAY *bd, unsigned char *buf, int len, int stride)
+{
+    BD_STREAM *st = &bd->st0;
+    int out_len = 0;
+
+    while (len >= 192) {
+
+        /* inserted PAT/PMT */
+        if (bd->tp_active && st->psi_pending) {
+            int psi_len = _insert_psi(st, buf, len, out_len);
+            if (!psi_len && st->psi_pending) {
+                return out_len;
+            }
+            buf += psi_len;
+            len -= psi_len;
+            out_len += psi_len;
+            continue;
+        }
+
+        /* next I-picture ? */
+        if (!bd->tp_active || SPN(st->clip_pos) >= bd->tp_end_pkt) {
+
+            /* split read()'s at I-picture boundary */
+            if (out_len) {
+                return out_len;
+            }
+
+            int r = _trickplay_next(bd, stride);
+            if (r <= 0) {
+                return r;
+            }
+            continue;
+        }
+
+        if (st->int_buf_off == 6144) {
+            /* m2ts filter is not used: only I-pictures are delivered */
+            M2TS_FILTER *filter = st->m2ts_filter;
+            int r;
+
+            st->m2ts_filter = NULL;
+            r = _read_block(bd, st, bd->int_buf);
+            st->m2ts_filter = filter;
+
+            if (r < 0) {
+                return -1;
+            }
+            if (r == 0) {
+                /* broken unit or EOF. Position was updated, continue with next unit. */
+                bd->s_pos = _title_pos(st->clip, SPN(st->clip_pos));
+                continue;
+            }
+
+            st->int_buf_off = st->clip_pos % 6144;
+
+            /* include PCR preceding the I-picture (and PAT/PMT if those were not inserted) */
+            if (st->seek_flag) {
+                st->seek_flag = 0;
+                _seek_rewind(bd, st, (st->psi_valid & PSI_PAT_PMT) == PSI_PAT_PMT);
+            }
+        }
+
+        /* copy video and PSI packets of current unit */
+        uint16_t video_pid = st->clip->cl->cpi.entry[0].pid;
+        while (st->int_buf_off < 6144 && len >= 192 && SPN(st->clip_pos) < bd->tp_end_pkt) {
+            const uint8_t *pkt = bd->int_buf + st->int_buf_off;
+            uint16_t pid = TS_PID(pkt);
+
+            if (pid == video_pid || pid <= HDMV_PID_PCR) {
+                memcpy(buf, pkt, 192);
+                buf += 192;
+                len -= 192;
+                out_len += 192;
+            }
+
+            st->int_buf_off += 192;
+            st->clip_pos += 192;
+            bd->s_pos += 192;
+        }
+    }
+
+    BD_DEBUG(DBG_STREAM, "Trick play: %d bytes read OK!\n", out_len);
+    return out_len;
+}
+
+int bd_read_trickplay(BLURAY *bd, unsigned char *buf, int len, int stride)
+{
+    int result = -1;
+
+    if (stride == 0) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_read_trickplay(): invalid stride\n");
+        return -1;
+    }
+
+    bd_mutex_lock(&bd->mutex);
+
+    if (!bd->st0.fp || !bd->st0.clip) {
+        BD_DEBUG(DBG_STREAM | DBG_CRIT, "bd_read_trickplay(): no valid title selected!\n");
+    } else {
+        result = _bd_read_trickplay(bd, buf, len, stride);
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return result;
+}
+
+/*
+ * in-kernel copy of unencrypted clips
+ */
+
+/* Unit aligned byte range of clip that does not need filtering.
+ * Units around play item in and out points (+ one GOP margin) are read with bd_read(). */
+static int _clip_copy_range(const NAV_CLIP *clip, uint64_t *start, uint64_t *end)
+{
+    int      ep_first, ep_last;
+    uint32_t first_pkt, last_pkt;
+
+    if (!clip->cl || clip->end_pkt <= clip->start_pkt) {
+        return 0;
+    }
+
+    ep_first = clpi_ep_find(clip->cl, clip->start_pkt);
+    ep_last  = clpi_ep_find(clip->cl, clip->end_pkt - 1);
+    if (ep_first < 0 || ep_last - ep_first < 4) {
+        return 0;
+    }
+
+    first_pkt = clpi_ep_entry(clip->cl, ep_first + 2, NULL, NULL);
+    last_pkt  = clpi_ep_entry(clip->cl, ep_last - 1, NULL, NULL);
+
+    *start = ((uint64_t)first_pkt * 192 + 6143) / 6144 * 6144;
+    *end   = ((uint64_t)last_pkt * 192) / 6144 * 6144;
+
+    return *start < *end;
+}
+
+/* limit time bd->mutex is held */
+#define COPY_MAX_SIZE (6144 * 512)
+
+static int64_t _bd_copy(BLURAY *bd, int fd, int64_t len)
+{
+    BD_STREAM *st = &bd->st0;
+    uint64_t   start, end;
+    int64_t    size, copied;
+
+    /* stream data is needed by internal decoders */
+    if (st->ig_pid > 0 || st->pg_pid > 0 || bd->st_textst.clip) {
+        return 0;
+    }
+
+    /* data is not validated: never copy possibly encrypted data */
+    if (bd->disc_info.aacs_detected || bd->disc_info.bdplus_detected) {
+        return 0;
+    }
+
+    if (st->psi_pending || st->seek_flag || bd->seamless_angle_change || bd->tp_active) {
+        return 0;
+    }
+
+    /* some streams have not reached in point yet */
+    if (st->m2ts_filter && m2ts_filter_active(st->m2ts_filter)) {
+        return 0;
+    }
+
+    if (!_clip_copy_range(st->clip, &start, &end)) {
+        return 0;
+    }
+    end = BD_MIN(end, st->clip_size / 6144 * 6144);
+
+    /* rest of partially read unit is not modified inside the range: copy it from file */
+    if (st->clip_pos / 6144 * 6144 < start || st->clip_pos >= end) {
+        return 0;
+    }
+
+    /* stop at unit boundary */
+    len  = BD_MIN(len, COPY_MAX_SIZE);
+    size = (st->clip_pos + BD_MIN((int64_t)(end - st->clip_pos), len)) / 6144 * 6144 - st->clip_pos;
+    if (size <= 0) {
+        return 0;
+    }
+
+    /* fails with encrypted clips and disc images */
+    copied = file_copy_range(st->fp, st->clip_pos, size, fd);
+    if (copied <= 0) {
+        return 0;
+    }
+
+    BD_DEBUG(DBG_STREAM, "Copied %" PRId64 " bytes at %" PRIu64 "\n", copied, st->clip_pos);
+
+    st->clip_pos      += copied;
+    st->clip_block_pos = st->clip_pos / 6144 * 6144;
+    st->int_buf_off    = 6144;
+    bd->s_pos         += copied;
+
+    /* next bd_read() continues from here (also after partial copy) */
+    if (file_seek(st->fp, st->clip_block_pos, SEEK_SET) < 0) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to seek clip %s!\n", st->clip->name);
+        return -1;
+    }
+
+    if (!st->prefetch_sent &&
+        st->clip_block_pos + PREFETCH_DISTANCE >= (uint64_t)st->clip->end_pkt * 192) {
+        _prefetch_next_clip(bd, st);
+    }
+
+    return copied;
+}
+
+int64_t bd_copy(BLURAY *bd, int fd, int64_t len)
+{
+    int64_t result = 0;
+
+    bd_mutex_lock(&bd->mutex);
+
+    if (!bd->st0.fp) {
+        BD_DEBUG(DBG_STREAM | DBG_CRIT, "bd_copy(): no valid title selected!\n");
+        result = -1;
+    } else if (bd->st0.clip) {
+        result = _bd_copy(bd, fd, len);
+
+        /* mark tracking */
+        if (result > 0 && bd->next_mark >= 0 && bd->s_pos > bd->next_mark_pos) {
+            _playmark_reached(bd);
+        }
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return result;
+}
+
 /*
  * synchronous sub paths
  */
@@ -2382,14 +3141,19 @@ static void _close_playlist(BLURAY *bd)
         }
     }
 
-    _close_m2ts(&bd->st0);
+    _close_m2ts(bd, &bd->st0);
     _close_preload(&bd->st_ig);
     _close_preload(&bd->st_textst);
 
+    graphics_processor_index_clear(&bd->pg_index);
+    bd->pg_index_clip = NULL;
+
     nav_title_close(&bd->title);
 
     bd->st0.clip = NULL;
 
+    bd->tp_active = 0;
+
     /* reset UO mask */
     memset(&bd->st0.uo_mask, 0, sizeof(BD_UO_MASK));
     memset(&bd->gc_uo_mask,  0, sizeof(BD_UO_MASK));
@@ -2458,12 +3222,20 @@ static int _open_playlist(BLURAY *bd, unsigned playlist, unsigned angle)
 
     _update_playlist_psrs(bd);
 
-    if (_open_m2ts(bd, &bd->st0)) {
+    int64_t trace = bd_trace_begin();
+    int     opened = _open_m2ts(bd, &bd->st0);
+    bd_trace_end(trace, "_open_m2ts", f_name);
+
+    if (opened) {
         BD_DEBUG(DBG_BLURAY, "Title %s selected\n", f_name);
 
         _find_next_playmark(bd);
 
+        trace = bd_trace_begin();
         _preload_subpaths(bd);
+        bd_trace_end(trace, "_preload_subpaths", f_name);
+
+        bd->trace_first_read = 1;
 
         bd->st0.seek_flag = 1;
 
@@ -2905,6 +3677,64 @@ void bd_free_title_info(BLURAY_TITLE_INFO *title_info)
     }
 }
 
+/*
+ * key frames
+ */
+
+BLURAY_KEYFRAME *bd_get_keyframes(BLURAY *bd, uint32_t playlist, const uint64_t *ticks, unsigned count)
+{
+    NAV_TITLE *title;
+    BLURAY_KEYFRAME *frames;
+    char mpls_name[11];
+    unsigned ii;
+
+    if (!bd || !bd->disc || !ticks || count < 1) {
+        return NULL;
+    }
+
+    if (playlist > 99999) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Invalid playlist %u!\n", playlist);
+        return NULL;
+    }
+
+    if (snprintf(mpls_name, sizeof(mpls_name), "%05u.mpls", playlist) != 10) {
+        return NULL;
+    }
+
+    frames = calloc(count, sizeof(*frames));
+    if (!frames) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "out of memory\n");
+        return NULL;
+    }
+    for (ii = 0; ii < count; ii++) {
+        frames[ii].request = ticks[ii];
+    }
+
+    title = nav_title_open(bd->disc, mpls_name, 0);
+    if (title == NULL) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to open title %s!\n", mpls_name);
+        X_FREE(frames);
+        return NULL;
+    }
+
+    keyframe_extract(bd->disc, title, frames, count);
+
+    nav_title_close(&title);
+    return frames;
+}
+
+void bd_free_keyframes(BLURAY_KEYFRAME *frames, unsigned count)
+{
+    unsigned ii;
+
+    if (frames) {
+        for (ii = 0; ii < count; ii++) {
+            X_FREE(frames[ii].data);
+        }
+        X_FREE(frames);
+    }
+}
+
 /*
  * player settings
  */
@@ -2946,6 +3776,34 @@ int bd_set_player_setting(BLURAY *bd, uint32_t idx, uint32_t value)
         return result;
     }
 
+    if (idx == BLURAY_PLAYER_SETTING_DECODE_THREAD) {
+        bd_mutex_lock(&bd->mutex);
+
+        bd->decode_thread = !!value;
+        result = 1;
+        if (bd->graphics_controller) {
+            result = !gc_set_async(bd->graphics_controller, bd->decode_thread);
+        }
+
+        bd_mutex_unlock(&bd->mutex);
+        return result;
+    }
+
+    if (idx == BLURAY_PLAYER_SETTING_OVERLAY_PALETTE) {
+        bd_mutex_lock(&bd->mutex);
+
+        result = 1;
+        if (bd->graphics_controller) {
+            result = !gc_set_palette_format(bd->graphics_controller, (int)value);
+        }
+        if (result) {
+            bd->overlay_palette = (int)value;
+        }
+
+        bd_mutex_unlock(&bd->mutex);
+        return result;
+    }
+
     if (idx == BLURAY_PLAYER_SETTING_PERSISTENT_STORAGE) {
         if (bd->title_type != title_undef) {
             BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Can't disable persistent storage during playback\n");
@@ -3043,6 +3901,8 @@ int bd_start_bdj(BLURAY *bd, const char *start_object)
         return 0;
     }
 
+    _fill_disc_info_bdj(bd);
+
     /* first play object ? */
     if (bd->disc_info.first_play_supported) {
         t = bd->disc_info.first_play;
@@ -3344,6 +4204,8 @@ static int _play_hdmv(BLURAY *bd, unsigned id_ref)
 
 static int _play_title(BLURAY *bd, unsigned title)
 {
+    _fill_disc_info_bdj(bd);
+
     if (!bd->disc_info.titles) {
         BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_play_title(#%d): No disc index\n", title);
         return 0;
@@ -3628,6 +4490,9 @@ static int _run_hdmv(BLURAY *bd)
 
 static int _read_ext(BLURAY *bd, unsigned char *buf, int len, BD_EVENT *event)
 {
+    /* menus may complete in decoder thread after last stream data was read */
+    _poll_gc_menu(bd);
+
     if (_get_event(bd, event)) {
         return 0;
     }
@@ -3838,6 +4703,35 @@ void bd_register_overlay_proc(BLURAY *bd, void *handle, bd_overlay_proc_f func)
 
     if (func) {
         bd->graphics_controller = gc_init(bd->regs, handle, func);
+        if (bd->graphics_controller && bd->overlay_palette) {
+            gc_set_palette_format(bd->graphics_controller, bd->overlay_palette);
+        }
+        if (bd->graphics_controller && bd->decode_thread) {
+            gc_set_async(bd->graphics_controller, 1);
+        }
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+}
+
+void bd_register_overlay_batch_proc(BLURAY *bd, void *handle, bd_overlay_batch_proc_f func)
+{
+    if (!bd) {
+        return;
+    }
+
+    bd_mutex_lock(&bd->mutex);
+
+    gc_free(&bd->graphics_controller);
+
+    if (func) {
+        bd->graphics_controller = gc_init_batch(bd->regs, handle, func);
+        if (bd->graphics_controller && bd->overlay_palette) {
+            gc_set_palette_format(bd->graphics_controller, bd->overlay_palette);
+        }
+        if (bd->graphics_controller && bd->decode_thread) {
+            gc_set_async(bd->graphics_controller, 1);
+        }
     }
 
     bd_mutex_unlock(&bd->mutex);
@@ -3875,6 +4769,11 @@ int bd_get_sound_effect(BLURAY *bd, unsigned sound_id, BLURAY_SOUND_EFFECT *effe
     if (sound_id < bd->sound_effects->num_sounds) {
         SOUND_OBJECT *o = &bd->sound_effects->sounds[sound_id];
 
+        /* samples are decoded on first use */
+        if (!sound_get_samples(bd->disc, bd->sound_effects, sound_id) && o->num_frames) {
+            return -1;
+        }
+
         effect->num_channels = o->num_channels;
         effect->num_frames   = o->num_frames;
         effect->samples      = (const int16_t *)o->samples;
@@ -3978,7 +4877,6 @@ int bd_get_meta_file(BLURAY *bd, const char *name, void **data, int64_t *size)
  * Database access
  */
 
-#include "bdnav/clpi_parse.h"
 #include "bdnav/mpls_parse.h"
 
 struct clpi_cl *bd_get_clpi(BLURAY *bd, unsigned clip_ref)
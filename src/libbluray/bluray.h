@@ -310,6 +310,18 @@ typedef struct bd_sound_effect {
     const int16_t  *samples;      /**< 48000 Hz, 16 bit LPCM. Interleaved if stereo */
 } BLURAY_SOUND_EFFECT;
 
+/** Key frame (I-picture) data */
+typedef struct bd_keyframe {
+    uint64_t        request;      /**< Requested playlist timestamp, 90 kHz */
+    uint64_t        pts;          /**< Playlist timestamp of the key frame, 90 kHz */
+    uint32_t        clip_ref;     /**< Play item number */
+    char            clip_id[6];   /**< Clip file name (5 digits) */
+    uint64_t        start;        /**< Start of the read byte range in clip file (aligned unit) */
+    uint64_t        end;          /**< End of the read byte range in clip file */
+    unsigned char  *data;         /**< PAT, PMT and I-picture (video) packets. NULL if not found. */
+    uint32_t        size;         /**< Size of data (multiple of 192 bytes) */
+} BLURAY_KEYFRAME;
+
 
 /**
  *  Get libbluray version
@@ -404,6 +416,30 @@ void bd_close(BLURAY *bd);
  */
 const BLURAY_DISC_INFO *bd_get_disc_info(BLURAY *bd);
 
+/* Disc open stage timing (milliseconds) */
+typedef struct {
+    uint32_t total;       /**< bd_open_*() total */
+    uint32_t filesystem;  /**< File system / UDF image open */
+    uint32_t decryption;  /**< libaacs / libbdplus initialization */
+    uint32_t index;       /**< index.bdmv parsing (runs in parallel with decryption) */
+
+    /* deferred until first use (bd_get_disc_info(), bd_play(), ...) */
+    uint32_t bdj;         /**< BD-J environment detection and id.bdmv parsing (0 if not done yet) */
+    uint32_t meta;        /**< Disc metadata parsing (0 if not done yet) */
+} BLURAY_OPEN_TIMING;
+
+/**
+ *
+ *  Get timing of disc open stages.
+ *
+ *  Title names (metadata) and BD-J support detection are not
+ *  resolved when disc is opened. They are resolved on first use.
+ *
+ * @param bd  BLURAY object
+ * @return pointer to BLURAY_OPEN_TIMING object, NULL on error
+ */
+const BLURAY_OPEN_TIMING *bd_get_open_timing(BLURAY *bd);
+
 /**
  *
  *  Get meta information about current BluRay disc.
@@ -523,6 +559,48 @@ uint32_t bd_get_current_title(BLURAY *bd);
  */
 int bd_read(BLURAY *bd, unsigned char *buf, int len);
 
+/**
+ *
+ *  Read I-pictures from currently selected title (trick play)
+ *
+ *  Only aligned units covering the I-pictures listed in clip EP map are read.
+ *  Returned data contains video and PAT/PMT/PCR packets only. PAT and PMT are
+ *  inserted before each I-picture.
+ *  Each call returns data from a single I-picture.
+ *
+ *  Next bd_read() continues normal playback from the last returned I-picture.
+ *
+ * @param bd  BLURAY object
+ * @param buf buffer to read data into
+ * @param len size of data to be read
+ * @param stride number of EP map entries to advance after each I-picture (< 0 for backward)
+ * @return size of data read, -1 if error, 0 if start or end of title was reached
+ */
+int bd_read_trickplay(BLURAY *bd, unsigned char *buf, int len, int stride);
+
+/**
+ *
+ *  Copy from currently selected title to file descriptor
+ *
+ *  Unencrypted clip data is copied in kernel (copy_file_range() / sendfile())
+ *  without passing through application buffers. Only the middle part of each
+ *  play item can be copied: data around play item boundaries is filtered and
+ *  must be read with bd_read(). Data is not validated.
+ *
+ *  When 0 is returned, application should read next aligned unit (6144 bytes)
+ *  with bd_read() and try again. Copy is not possible with encrypted discs,
+ *  disc images or when PG / IG / TextST decoding is active.
+ *  At most 3 MB is copied in one call.
+ *
+ *  Not supported on all platforms.
+ *
+ * @param bd  BLURAY object
+ * @param fd  file descriptor to write data to (at current position)
+ * @param len maximum size of data to be copied
+ * @return size of data copied, -1 if error, 0 if data must be read with bd_read()
+ */
+int64_t bd_copy(BLURAY *bd, int fd, int64_t len);
+
 
 /*
  * Playback control functions
@@ -710,8 +788,14 @@ typedef enum {
     BLURAY_PLAYER_SETTING_TEXT_CAP       = 30,    /**< Text Subtitle capability.    Bit mask. */
     BLURAY_PLAYER_SETTING_PLAYER_PROFILE = 31,    /**< Player profile and version. */
 
-    BLURAY_PLAYER_SETTING_DECODE_PG          = 0x100, /**< Enable/disable PG (subtitle) decoder. Integer. Default: disabled. */
+    BLURAY_PLAYER_SETTING_DECODE_PG          = 0x100, /**< Enable/disable PG (subtitle) decoder. Integer. Default: disabled.
+                                                           After a seek back to already played part of a clip, subtitles
+                                                           active at the seek point are shown immediately. After other seeks
+                                                           subtitles appear at the next PG epoch start or acquisition point. */
     BLURAY_PLAYER_SETTING_PERSISTENT_STORAGE = 0x101, /**< Enable/disable BD-J persistent storage. Integer. Default: enabled. */
+    BLURAY_PLAYER_SETTING_DECODE_THREAD      = 0x102, /**< Decode IG/PG streams in background thread. Integer. Default: disabled.
+                                                           PG overlay callbacks are called from the decoder thread. */
+    BLURAY_PLAYER_SETTING_OVERLAY_PALETTE    = 0x103, /**< Deliver YUV overlay palettes converted to ARGB. Integer. Default: disabled. */
 
     BLURAY_PLAYER_PERSISTENT_ROOT            = 0x200, /**< Root path to the BD_J persistent storage location. String. */
     BLURAY_PLAYER_CACHE_ROOT                 = 0x201, /**< Root path to the BD_J cache storage location. String. */
@@ -899,6 +983,7 @@ const char *bd_event_name(uint32_t /* bd_event_e */ event);
  */
 
 struct bd_overlay_s;      /* defined in overlay.h */
+struct bd_overlay_batch_s; /* defined in overlay.h */
 struct bd_argb_overlay_s; /* defined in overlay.h */
 struct bd_argb_buffer_s;  /* defined in overlay.h */
 
@@ -939,6 +1024,30 @@ typedef void (*bd_argb_overlay_proc_f)(void *handle, const struct bd_argb_overla
  */
 void bd_register_overlay_proc(BLURAY *bd, void *handle, bd_overlay_proc_f func);
 
+/**
+ * YUV overlay batch handler function type
+ *
+ * @param handle opaque handle that was given to bd_register_overlay_batch_proc()
+ * @param batch  \ref BD_OVERLAY_BATCH (NULL when graphics controller is closed)
+ */
+typedef void (*bd_overlay_batch_proc_f)(void *handle, const struct bd_overlay_batch_s * const batch);
+
+/**
+ *
+ *  Register handler for batched compressed YUV overlays
+ *
+ *  Same as bd_register_overlay_proc(), but overlay events are collected
+ *  and delivered with single call for each FLUSH event.
+ *
+ *  Registering batch handler replaces handler registered with
+ *  bd_register_overlay_proc() (and vice versa).
+ *
+ * @param bd  BLURAY object
+ * @param handle application-specific handle that will be passed to handler function
+ * @param func handler function pointer
+ */
+void bd_register_overlay_batch_proc(BLURAY *bd, void *handle, bd_overlay_batch_proc_f func);
+
 /**
  *
  *  Register handler for ARGB overlays
@@ -1043,6 +1152,32 @@ BLURAY_TITLE_INFO* bd_get_playlist_info(BLURAY *bd, uint32_t playlist, unsigned
  */
 int bd_get_sound_effect(BLURAY *bd, unsigned sound_id, struct bd_sound_effect *effect);
 
+/**
+ *
+ *  Get key frames (ex. for thumbnails)
+ *
+ *  Nearest I-picture in clip EP map is returned for each timestamp.
+ *  Returned data is a self-contained transport stream fragment (PAT, PMT and the
+ *  video packets of the I-picture). Only the aligned units covering the I-picture
+ *  are read from the disc. Different clips are read in parallel.
+ *
+ * @param bd  BLURAY object
+ * @param playlist playlist number
+ * @param ticks  playlist timestamps (90 kHz)
+ * @param count  number of timestamps
+ * @return allocated array of count BLURAY_KEYFRAME objects, NULL on error
+ */
+BLURAY_KEYFRAME *bd_get_keyframes(BLURAY *bd, uint32_t playlist, const uint64_t *ticks, unsigned count);
+
+/**
+ *
+ *  Free key frames returned by bd_get_keyframes()
+ *
+ * @param frames  BLURAY_KEYFRAME array
+ * @param count  number of key frames
+ */
+void bd_free_keyframes(BLURAY_KEYFRAME *frames, unsigned count);
+
 
 /*
  * User interaction
@@ -27,12 +27,14 @@
 #include "hdmv_pids.h"
 #include "ig.h"
 #include "overlay.h"
+#include "../player_settings.h"
 #include "textst_render.h"
 #include "rle.h"
 
 #include "util/macro.h"
 #include "util/logging.h"
 #include "util/mutex.h"
+#include "util/thread.h"
 #include "util/time.h"
 
 #include "bdnav/uo_mask.h"
@@ -46,6 +48,7 @@
 #endif
 
 #include <inttypes.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define GC_ERROR(...) BD_DEBUG(DBG_GC | DBG_CRIT, __VA_ARGS__)
@@ -63,6 +66,73 @@ typedef struct {
     int      effect_running;  /* single-loop animation not yet complete */
 } BOG_DATA;
 
+/* queued IG/PG input for background decoding */
+#define GC_QUEUE_MAX 64   /* max. queued units */
+
+typedef struct gc_queue_item_s GC_QUEUE_ITEM;
+struct gc_queue_item_s {
+    GC_QUEUE_ITEM *next;
+    uint16_t       pid;
+    unsigned       num_blocks;
+    uint8_t        block[];
+};
+
+typedef struct {
+    BD_THREAD      thread;
+    BD_MUTEX       mutex;
+    BD_COND        cond;
+    GC_QUEUE_ITEM *head;
+    GC_QUEUE_ITEM *tail;
+    unsigned       count;
+    unsigned       busy;      /* worker is decoding an item */
+    unsigned       exit;      /* worker should terminate */
+    unsigned       ig_ready;  /* new complete IG display set was decoded */
+} GC_WORKER;
+
+/* composition object of last rendered effect frame */
+typedef struct {
+    BD_PG_COMPOSITION_OBJECT cobj;
+    uint16_t w, h;            /* rendered size (0 if object was not found) */
+    uint8_t  redrawn;         /* drawn when this frame was rendered */
+} EFFECT_OBJ;
+
+/* uniform grid for mouse hit testing.
+ * Each cell lists (in bog order) the enabled buttons whose SELECTED state object overlaps the cell. */
+#define HIT_GRID_COLS 16
+#define HIT_GRID_ROWS 16
+
+typedef struct {
+    uint16_t      x, y, w, h;   /* selectable area */
+    BD_IG_BUTTON *button;
+} HIT_RECT;
+
+typedef struct {
+    int         valid;
+    BD_IG_PAGE *page;          /* page the grid was built for */
+    unsigned    cell_w, cell_h;
+
+    HIT_RECT    rect[MAX_NUM_BOGS];
+    uint32_t    cell_start[HIT_GRID_COLS * HIT_GRID_ROWS + 1];  /* index to bog[] */
+    uint8_t    *bog;
+    unsigned    bog_size;
+} HIT_GRID;
+
+#define PALETTE_CACHE_SIZE 4
+
+typedef struct {
+    uint8_t             valid;
+    BD_PG_PALETTE_ENTRY src[256];
+    uint32_t            argb[256];
+} PALETTE_CACHE_ENTRY;
+
+typedef struct {
+    BD_OVERLAY          *cmd;
+    BD_PG_PALETTE_ENTRY *palette;   /* palette copy for each command (256 entries / command) */
+    uint32_t            *palette_argb; /* converted palette copy for each command (256 entries / command) */
+    unsigned             num_cmds;
+    unsigned             size;
+} OVERLAY_BATCH;
+
 struct graphics_controller_s {
 
     BD_REGISTERS   *regs;
@@ -73,6 +143,16 @@ struct graphics_controller_s {
     void           *overlay_proc_handle;
     void          (*overlay_proc)(void *, const struct bd_overlay_s * const);
 
+    /* batched overlay output (overlay_proc collects commands) */
+    void           *batch_proc_handle;
+    void          (*batch_proc)(void *, const struct bd_overlay_batch_s * const);
+    OVERLAY_BATCH   batch[2];       /* pending commands for PG and IG planes */
+
+    /* ARGB palettes */
+    int                 palette_format;  /* BLURAY_PALETTE_*, 0 = disabled */
+    PALETTE_CACHE_ENTRY palette_cache[PALETTE_CACHE_SIZE];
+    unsigned            palette_cache_next;  /* next entry to replace */
+
     /* state */
     unsigned        ig_open;
     unsigned        ig_drawn;
@@ -86,6 +166,7 @@ struct graphics_controller_s {
     BOG_DATA        bog_data[MAX_NUM_BOGS];
     BOG_DATA       *saved_bog_data;
     BD_UO_MASK      page_uo_mask;
+    HIT_GRID        hit_grid;         /* mouse hit testing (valid only for current IG page and enabled buttons) */
 
     /* page effects */
     unsigned               effect_idx;
@@ -93,6 +174,11 @@ struct graphics_controller_s {
     BD_IG_EFFECT_SEQUENCE *out_effects;
     int64_t                next_effect_time; /* 90 kHz */
 
+    /* last rendered effect frame (damage tracking) */
+    EFFECT_OBJ            *effect_obj;
+    unsigned               num_effect_obj;
+    int                    effect_palette_id; /* < 0: IG plane does not contain effect frame */
+
     /* timers */
     int64_t                user_timeout;
 
@@ -113,8 +199,11 @@ struct graphics_controller_s {
 
     /* */
     TEXTST_RENDER  *textst_render;
-    int             next_dialog_idx;
+    int             next_dialog_idx;  /* position in presentation order, < 0: locate from current time */
     int             textst_user_style;
+
+    /* background decoding of IG/PG streams (NULL if disabled) */
+    GC_WORKER      *worker;
 };
 
 /*
@@ -125,6 +214,10 @@ static BD_PG_OBJECT *_find_object(PG_DISPLAY_SET *s, unsigned object_id)
 {
     unsigned ii;
 
+    if (s->index_valid) {
+        return object_id < s->object_index_size ? s->object_index[object_id] : NULL;
+    }
+
     for (ii = 0; ii < s->num_object; ii++) {
         if (s->object[ii].id == object_id) {
             return &s->object[ii];
@@ -138,6 +231,10 @@ static BD_PG_PALETTE *_find_palette(PG_DISPLAY_SET *s, unsigned palette_id)
 {
     unsigned ii;
 
+    if (s->index_valid) {
+        return palette_id < 256 ? s->palette_index[palette_id] : NULL;
+    }
+
     for (ii = 0; ii < s->num_palette; ii++) {
         if (s->palette[ii].id == palette_id) {
             return &s->palette[ii];
@@ -147,10 +244,33 @@ static BD_PG_PALETTE *_find_palette(PG_DISPLAY_SET *s, unsigned palette_id)
     return NULL;
 }
 
-static BD_IG_BUTTON *_find_button_bog(BD_IG_BOG *bog, unsigned button_id)
+static PG_BUTTON_INDEX *_button_index(PG_DISPLAY_SET *s, BD_IG_PAGE *page)
 {
+    if (s->index_valid && s->ics) {
+        BD_IG_INTERACTIVE_COMPOSITION *c = &s->ics->interactive_composition;
+        if (page >= c->page && page < c->page + s->num_button_index) {
+            return &s->button_index[page - c->page];
+        }
+    }
+    return NULL;
+}
+
+static BD_IG_BUTTON *_find_button_bog(PG_DISPLAY_SET *s, BD_IG_PAGE *page, unsigned bog_idx, unsigned button_id)
+{
+    PG_BUTTON_INDEX *bi = _button_index(s, page);
+    BD_IG_BOG *bog = &page->bog[bog_idx];
     unsigned ii;
 
+    if (bi) {
+        if (button_id >= bi->size || !bi->button[button_id]) {
+            return NULL;
+        }
+        if (bi->bog[button_id] == bog_idx) {
+            return bi->button[button_id];
+        }
+        /* button id is used in multiple bogs, fall back to linear search */
+    }
+
     for (ii = 0; ii < bog->num_buttons; ii++) {
         if (bog->button[ii].id == button_id) {
             return &bog->button[ii];
@@ -160,12 +280,23 @@ static BD_IG_BUTTON *_find_button_bog(BD_IG_BOG *bog, unsigned button_id)
     return NULL;
 }
 
-static BD_IG_BUTTON *_find_button_page(BD_IG_PAGE *page, unsigned button_id, unsigned *bog_idx)
+static BD_IG_BUTTON *_find_button_page(PG_DISPLAY_SET *s, BD_IG_PAGE *page, unsigned button_id, unsigned *bog_idx)
 {
+    PG_BUTTON_INDEX *bi = _button_index(s, page);
     unsigned ii;
 
+    if (bi) {
+        if (button_id < bi->size && bi->button[button_id]) {
+            if (bog_idx) {
+                *bog_idx = bi->bog[button_id];
+            }
+            return bi->button[button_id];
+        }
+        return NULL;
+    }
+
     for (ii = 0; ii < page->num_bogs; ii++) {
-        BD_IG_BUTTON *button = _find_button_bog(&page->bog[ii], button_id);
+        BD_IG_BUTTON *button = _find_button_bog(s, page, ii, button_id);
         if (button) {
             if (bog_idx) {
                 *bog_idx = ii;
@@ -177,10 +308,15 @@ static BD_IG_BUTTON *_find_button_page(BD_IG_PAGE *page, unsigned button_id, uns
     return NULL;
 }
 
-static BD_IG_PAGE *_find_page(BD_IG_INTERACTIVE_COMPOSITION *c, unsigned page_id)
+static BD_IG_PAGE *_find_page(PG_DISPLAY_SET *s, unsigned page_id)
 {
+    BD_IG_INTERACTIVE_COMPOSITION *c = &s->ics->interactive_composition;
     unsigned ii;
 
+    if (s->index_valid) {
+        return page_id < 256 ? s->page_index[page_id] : NULL;
+    }
+
     for (ii = 0; ii < c->num_pages; ii++) {
         if (c->page[ii].id == page_id) {
             return &c->page[ii];
@@ -298,7 +434,7 @@ static uint16_t _find_selected_button_id(GRAPHICS_CONTROLLER *gc)
     unsigned        button_id = bd_psr_read(gc->regs, PSR_SELECTED_BUTTON_ID);
     unsigned        ii;
 
-    page = _find_page(&s->ics->interactive_composition, page_id);
+    page = _find_page(s, page_id);
     if (!page) {
         GC_TRACE("_find_selected_button_id(): unknown page #%d (have %d pages)\n",
               page_id, s->ics->interactive_composition.num_pages);
@@ -308,7 +444,7 @@ static uint16_t _find_selected_button_id(GRAPHICS_CONTROLLER *gc)
     /* run 5.9.8.3 */
 
     /* 1) always use page->default_selected_button_id_ref if it is valid */
-    if (_find_button_page(page, page->default_selected_button_id_ref, NULL) &&
+    if (_find_button_page(s, page, page->default_selected_button_id_ref, NULL) &&
         _is_button_enabled(gc, page, page->default_selected_button_id_ref)) {
 
         GC_TRACE("_find_selected_button_id() -> default #%d\n", page->default_selected_button_id_ref);
@@ -317,11 +453,10 @@ static uint16_t _find_selected_button_id(GRAPHICS_CONTROLLER *gc)
 
     /* 2) fallback to current PSR10 value if it is valid */
     for (ii = 0; ii < page->num_bogs; ii++) {
-        BD_IG_BOG *bog = &page->bog[ii];
-        uint16_t   enabled_button = gc->bog_data[ii].enabled_button;
+        uint16_t enabled_button = gc->bog_data[ii].enabled_button;
 
         if (button_id == enabled_button) {
-            if (_find_button_bog(bog, enabled_button)) {
+            if (_find_button_bog(s, page, ii, enabled_button)) {
                 GC_TRACE("_find_selected_button_id() -> PSR10 #%d\n", enabled_button);
                 return enabled_button;
             }
@@ -330,10 +465,9 @@ static uint16_t _find_selected_button_id(GRAPHICS_CONTROLLER *gc)
 
     /* 3) fallback to find first valid_button_id_ref from page */
     for (ii = 0; ii < page->num_bogs; ii++) {
-        BD_IG_BOG *bog = &page->bog[ii];
-        uint16_t   enabled_button = gc->bog_data[ii].enabled_button;
+        uint16_t enabled_button = gc->bog_data[ii].enabled_button;
 
-        if (_find_button_bog(bog, enabled_button)) {
+        if (_find_button_bog(s, page, ii, enabled_button)) {
             GC_TRACE("_find_selected_button_id() -> first valid #%d\n", enabled_button);
             return enabled_button;
         }
@@ -369,7 +503,7 @@ static int _save_page_state(GRAPHICS_CONTROLLER *gc)
     unsigned        page_id = bd_psr_read(gc->regs, PSR_MENU_PAGE_ID);
     unsigned        ii;
 
-    page = _find_page(&s->ics->interactive_composition, page_id);
+    page = _find_page(s, page_id);
     if (!page) {
         GC_ERROR("_save_page_state(): unknown page #%d (have %d pages)\n",
               page_id, s->ics->interactive_composition.num_pages);
@@ -401,6 +535,7 @@ static int _restore_page_state(GRAPHICS_CONTROLLER *gc)
     if (gc->saved_bog_data) {
         memcpy(gc->bog_data, gc->saved_bog_data, sizeof(gc->bog_data));
         X_FREE(gc->saved_bog_data);
+        gc->hit_grid.valid = 0;
         return 1;
     }
     return -1;
@@ -413,7 +548,7 @@ static void _reset_page_state(GRAPHICS_CONTROLLER *gc)
     unsigned        page_id = bd_psr_read(gc->regs, PSR_MENU_PAGE_ID);
     unsigned        ii;
 
-    page = _find_page(&s->ics->interactive_composition, page_id);
+    page = _find_page(s, page_id);
     if (!page) {
         GC_ERROR("_reset_page_state(): unknown page #%d (have %d pages)\n",
               page_id, s->ics->interactive_composition.num_pages);
@@ -421,6 +556,7 @@ static void _reset_page_state(GRAPHICS_CONTROLLER *gc)
     }
 
     memset(gc->bog_data, 0, sizeof(gc->bog_data));
+    gc->hit_grid.valid = 0;
 
     for (ii = 0; ii < page->num_bogs; ii++) {
         gc->bog_data[ii].enabled_button = page->bog[ii].default_valid_button_id_ref;
@@ -449,6 +585,213 @@ static void _reset_page_state(GRAPHICS_CONTROLLER *gc)
     _reset_user_timeout(gc);
 }
 
+/*
+ * batched overlay output
+ */
+
+static void _batch_release(OVERLAY_BATCH *b)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < b->num_cmds; ii++) {
+        refcnt_dec(b->cmd[ii].img);
+    }
+    b->num_cmds = 0;
+}
+
+static int _batch_grow(OVERLAY_BATCH *b)
+{
+    unsigned             size = b->size ? 2 * b->size : 16;
+    BD_OVERLAY          *cmd;
+    BD_PG_PALETTE_ENTRY *palette;
+    uint32_t            *argb;
+
+    cmd = realloc(b->cmd, size * sizeof(*cmd));
+    if (!cmd) {
+        return -1;
+    }
+    b->cmd = cmd;
+
+    palette = realloc(b->palette, size * 256 * sizeof(*palette));
+    if (!palette) {
+        return -1;
+    }
+    b->palette = palette;
+
+    argb = realloc(b->palette_argb, size * 256 * sizeof(*argb));
+    if (!argb) {
+        return -1;
+    }
+    b->palette_argb = argb;
+
+    b->size = size;
+    return 0;
+}
+
+static void _batch_deliver(GRAPHICS_CONTROLLER *gc, unsigned plane)
+{
+    OVERLAY_BATCH    *b = &gc->batch[plane];
+    BD_OVERLAY_BATCH  batch;
+    unsigned          ii;
+
+    if (!b->num_cmds) {
+        return;
+    }
+
+    /* palette buffer may have been moved while collecting commands */
+    for (ii = 0; ii < b->num_cmds; ii++) {
+        if (b->cmd[ii].palette) {
+            b->cmd[ii].palette = &b->palette[ii * 256];
+        }
+        if (b->cmd[ii].palette_argb) {
+            b->cmd[ii].palette_argb = &b->palette_argb[ii * 256];
+        }
+    }
+
+    batch.plane    = plane;
+    batch.num_cmds = b->num_cmds;
+    batch.cmds     = b->cmd;
+
+    gc->batch_proc(gc->batch_proc_handle, &batch);
+
+    _batch_release(b);
+}
+
+/* overlay_proc in batch mode */
+static void _batch_add(void *handle, const BD_OVERLAY * const ov)
+{
+    GRAPHICS_CONTROLLER *gc = handle;
+    OVERLAY_BATCH       *b;
+    BD_OVERLAY          *cmd;
+
+    if (!ov) {
+        /* graphics controller is closed */
+        _batch_deliver(gc, BD_OVERLAY_PG);
+        _batch_deliver(gc, BD_OVERLAY_IG);
+        gc->batch_proc(gc->batch_proc_handle, NULL);
+        return;
+    }
+
+    if (ov->plane > BD_OVERLAY_IG) {
+        GC_ERROR("_batch_add(): invalid plane %d\n", ov->plane);
+        return;
+    }
+
+    b = &gc->batch[ov->plane];
+
+    if (b->num_cmds >= b->size && _batch_grow(b) < 0) {
+        /* deliver pending commands and this one without copying */
+        BD_OVERLAY_BATCH batch;
+
+        GC_ERROR("_batch_add(): out of memory\n");
+
+        _batch_deliver(gc, ov->plane);
+
+        batch.plane    = ov->plane;
+        batch.num_cmds = 1;
+        batch.cmds     = ov;
+        gc->batch_proc(gc->batch_proc_handle, &batch);
+        return;
+    }
+
+    /* source image and palette may change (or be freed) before next FLUSH */
+    cmd = &b->cmd[b->num_cmds];
+    *cmd = *ov;
+    if (ov->img) {
+        cmd->img = refcnt_inc(ov->img);
+        if (!cmd->img) {
+            GC_ERROR("_batch_add(): invalid image\n");
+            return;
+        }
+    }
+    if (ov->palette) {
+        memcpy(&b->palette[b->num_cmds * 256], ov->palette, 256 * sizeof(*b->palette));
+    }
+    if (ov->palette_argb) {
+        memcpy(&b->palette_argb[b->num_cmds * 256], ov->palette_argb, 256 * sizeof(*b->palette_argb));
+    }
+    b->num_cmds++;
+
+    switch (ov->cmd) {
+        case BD_OVERLAY_INIT:
+        case BD_OVERLAY_CLOSE:
+        case BD_OVERLAY_FLUSH:
+            _batch_deliver(gc, ov->plane);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * ARGB palettes
+ */
+
+static void _convert_palette(uint32_t *argb, const BD_PG_PALETTE_ENTRY *palette, int format)
+{
+    /* limited range YCbCr -> RGB, 16.16 fixed point: Cr->R, Cb->G, Cr->G, Cb->B */
+    static const int32_t coef[3][4] = {
+        { 104597, 25675, 53279, 132201 },  /* BT.601 */
+        { 117489, 13975, 34925, 138438 },  /* BT.709 */
+        { 110014, 12277, 42626, 140363 },  /* BT.2020 */
+    };
+    const int32_t *c = coef[(format & 0x0f) - 1];
+    int premultiplied = !!(format & BLURAY_PALETTE_PREMULTIPLIED);
+    unsigned ii;
+
+    for (ii = 0; ii < 256; ii++) {
+        int32_t y  = 76309 * (palette[ii].Y - 16) + 32768;
+        int32_t cb = palette[ii].Cb - 128;
+        int32_t cr = palette[ii].Cr - 128;
+        int32_t r  = (y + c[0] * cr) >> 16;
+        int32_t g  = (y - c[1] * cb - c[2] * cr) >> 16;
+        int32_t b  = (y + c[3] * cb) >> 16;
+        uint32_t a = palette[ii].T;
+
+        r = r < 0 ? 0 : r > 255 ? 255 : r;
+        g = g < 0 ? 0 : g > 255 ? 255 : g;
+        b = b < 0 ? 0 : b > 255 ? 255 : b;
+
+        if (premultiplied) {
+            r = (r * a + 127) / 255;
+            g = (g * a + 127) / 255;
+            b = (b * a + 127) / 255;
+        }
+
+        argb[ii] = (a << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
+    }
+
+    /* entry 0xff is always transparent */
+    argb[0xff] = 0;
+}
+
+/* return converted palette. Palettes are converted only once (fades update palette only). */
+static const uint32_t *_palette_argb(GRAPHICS_CONTROLLER *gc, const BD_PG_PALETTE_ENTRY *palette)
+{
+    PALETTE_CACHE_ENTRY *e;
+    unsigned ii;
+
+    if (!gc->palette_format || !palette) {
+        return NULL;
+    }
+
+    for (ii = 0; ii < PALETTE_CACHE_SIZE; ii++) {
+        e = &gc->palette_cache[ii];
+        if (e->valid && !memcmp(e->src, palette, sizeof(e->src))) {
+            return e->argb;
+        }
+    }
+
+    e = &gc->palette_cache[gc->palette_cache_next];
+    gc->palette_cache_next = (gc->palette_cache_next + 1) % PALETTE_CACHE_SIZE;
+
+    memcpy(e->src, palette, sizeof(e->src));
+    _convert_palette(e->argb, palette, gc->palette_format);
+    e->valid = 1;
+
+    return e->argb;
+}
+
 /*
  * overlay operations
  */
@@ -495,6 +838,7 @@ static void _close_osd(GRAPHICS_CONTROLLER *gc, int plane)
     if (plane == BD_OVERLAY_IG) {
         gc->ig_open = 0;
         gc->ig_drawn = 0;
+        gc->effect_palette_id = -1;
     } else {
         gc->pg_open = 0;
         gc->pg_drawn = 0;
@@ -556,6 +900,7 @@ static void _clear_osd(GRAPHICS_CONTROLLER *gc, int plane)
 
     if (plane == BD_OVERLAY_IG) {
         gc->ig_drawn      = 0;
+        gc->effect_palette_id = -1;
     } else {
         gc->pg_drawn      = 0;
     }
@@ -571,6 +916,7 @@ static void _clear_bog_area(GRAPHICS_CONTROLLER *gc, BOG_DATA *bog_data)
         bog_data->visible_object_id = -1;
 
         gc->ig_dirty = 1;
+        gc->effect_palette_id = -1;
     }
 }
 
@@ -592,6 +938,8 @@ static void _render_object(GRAPHICS_CONTROLLER *gc,
         ov.palette = palette->entry;
         ov.img     = object->img;
 
+        ov.palette_argb = _palette_argb(gc, ov.palette);
+
         gc->overlay_proc(gc->overlay_proc_handle, &ov);
     }
 }
@@ -631,6 +979,7 @@ static void _render_composition_object(GRAPHICS_CONTROLLER *gc,
         }
 
         ov.palette_update_flag = palette_update_flag;
+        ov.palette_argb        = _palette_argb(gc, ov.palette);
 
         gc->overlay_proc(gc->overlay_proc_handle, &ov);
 
@@ -669,6 +1018,8 @@ static void _render_rle(GRAPHICS_CONTROLLER *gc,
         ov.palette = palette;
         ov.img     = img;
 
+        ov.palette_argb = _palette_argb(gc, ov.palette);
+
         gc->overlay_proc(gc->overlay_proc_handle, &ov);
     }
 }
@@ -684,8 +1035,8 @@ static void _select_button(GRAPHICS_CONTROLLER *gc, uint32_t button_id)
     unsigned        bog_idx    = 0;
 
     /* reset animation */
-    page = _find_page(&gc->igs->ics->interactive_composition, page_id);
-    if (page && _find_button_page(page, button_id, &bog_idx)) {
+    page = _find_page(gc->igs, page_id);
+    if (page && _find_button_page(gc->igs, page, button_id, &bog_idx)) {
         gc->bog_data[bog_idx].animate_indx = 0;
         gc->next_effect_time = bd_get_scr();
     }
@@ -710,14 +1061,14 @@ static void _select_page(GRAPHICS_CONTROLLER *gc, uint16_t page_id, int out_effe
     gc->valid_mouse_position = 0;
 
     if (out_effects) {
-        page = _find_page(&gc->igs->ics->interactive_composition, cur_page_id);
+        page = _find_page(gc->igs, cur_page_id);
         if (page && page->out_effects.num_effects) {
             gc->next_effect_time = bd_get_scr();
             gc->out_effects = &page->out_effects;
         }
     }
 
-    page = _find_page(&gc->igs->ics->interactive_composition, page_id);
+    page = _find_page(gc->igs, page_id);
     if (page && page->in_effects.num_effects) {
         gc->next_effect_time = bd_get_scr();
         gc->in_effects = &page->in_effects;
@@ -750,10 +1101,13 @@ static void _gc_reset(GRAPHICS_CONTROLLER *gc)
     pg_display_set_free(&gc->tgs);
 
     textst_render_free(&gc->textst_render);
-    gc->next_dialog_idx = 0;
+    gc->next_dialog_idx = -1;
     gc->textst_user_style = -1;
 
     memset(gc->bog_data, 0, sizeof(gc->bog_data));
+    gc->hit_grid.valid = 0;
+    gc->effect_palette_id = -1;
+    gc->num_effect_obj = 0;
 }
 
 /*
@@ -816,15 +1170,60 @@ GRAPHICS_CONTROLLER *gc_init(BD_REGISTERS *regs, void *handle, gc_overlay_proc_f
     bd_psr_register_cb(regs, _process_psr_event, p);
 
     p->textst_user_style = -1;
+    p->next_dialog_idx   = -1;
+    p->effect_palette_id = -1;
 
     return p;
 }
 
+GRAPHICS_CONTROLLER *gc_init_batch(BD_REGISTERS *regs, void *handle, gc_overlay_batch_proc_f func)
+{
+    GRAPHICS_CONTROLLER *p = gc_init(regs, NULL, func ? _batch_add : NULL);
+
+    if (p) {
+        p->overlay_proc_handle = p;
+        p->batch_proc_handle   = handle;
+        p->batch_proc          = func;
+    }
+
+    return p;
+}
+
+int gc_set_palette_format(GRAPHICS_CONTROLLER *gc, int format)
+{
+    unsigned ii;
+
+    if (format & ~(0x0f | BLURAY_PALETTE_PREMULTIPLIED) || (format & 0x0f) > BLURAY_PALETTE_BT2020) {
+        GC_ERROR("gc_set_palette_format(): unsupported format 0x%x\n", format);
+        return -1;
+    }
+    if (format && !(format & 0x0f)) {
+        /* flags without color matrix */
+        format = BLURAY_PALETTE_NONE;
+    }
+
+    bd_mutex_lock(&gc->mutex);
+
+    if (gc->palette_format != format) {
+        gc->palette_format = format;
+        for (ii = 0; ii < PALETTE_CACHE_SIZE; ii++) {
+            gc->palette_cache[ii].valid = 0;
+        }
+    }
+
+    bd_mutex_unlock(&gc->mutex);
+
+    return 0;
+}
+
 void gc_free(GRAPHICS_CONTROLLER **p)
 {
     if (p && *p) {
 
         GRAPHICS_CONTROLLER *gc = *p;
+        unsigned ii;
+
+        gc_set_async(gc, 0);
 
         bd_psr_unregister_cb(gc->regs, _process_psr_event, gc);
 
@@ -837,6 +1236,15 @@ void gc_free(GRAPHICS_CONTROLLER **p)
         bd_mutex_destroy(&gc->mutex);
 
         X_FREE(gc->saved_bog_data);
+        X_FREE(gc->hit_grid.bog);
+        X_FREE(gc->effect_obj);
+
+        for (ii = 0; ii < 2; ii++) {
+            _batch_release(&gc->batch[ii]);
+            X_FREE(gc->batch[ii].cmd);
+            X_FREE(gc->batch[ii].palette);
+            X_FREE(gc->batch[ii].palette_argb);
+        }
 
         X_FREE(*p);
     }
@@ -846,13 +1254,8 @@ void gc_free(GRAPHICS_CONTROLLER **p)
  * graphics stream input
  */
 
-int gc_decode_ts(GRAPHICS_CONTROLLER *gc, uint16_t pid, uint8_t *block, unsigned num_blocks, int64_t stc)
+static int _decode_ts(GRAPHICS_CONTROLLER *gc, uint16_t pid, uint8_t *block, unsigned num_blocks, int64_t stc)
 {
-    if (!gc) {
-        GC_TRACE("gc_decode_ts(): no graphics controller\n");
-        return -1;
-    }
-
     if (IS_HDMV_PID_IG(pid)) {
         /* IG stream */
 
@@ -865,6 +1268,10 @@ int gc_decode_ts(GRAPHICS_CONTROLLER *gc, uint16_t pid, uint8_t *block, unsigned
 
         bd_mutex_lock(&gc->mutex);
 
+        /* display set may be modified */
+        gc->hit_grid.valid = 0;
+        gc->effect_palette_id = -1;
+
         if (!graphics_processor_decode_ts(gc->igp, &gc->igs,
                                           pid, block, num_blocks,
                                           stc)) {
@@ -905,14 +1312,18 @@ int gc_decode_ts(GRAPHICS_CONTROLLER *gc, uint16_t pid, uint8_t *block, unsigned
                 return -1;
             }
         }
+        bd_mutex_lock(&gc->mutex);
+
         graphics_processor_decode_ts(gc->pgp, &gc->pgs,
                                      pid, block, num_blocks,
                                      stc);
 
         if (!gc->pgs || !gc->pgs->complete) {
+            bd_mutex_unlock(&gc->mutex);
             return 0;
         }
 
+        bd_mutex_unlock(&gc->mutex);
         return 1;
     }
 
@@ -938,6 +1349,236 @@ int gc_decode_ts(GRAPHICS_CONTROLLER *gc, uint16_t pid, uint8_t *block, unsigned
     return -1;
 }
 
+/*
+ * background decoding
+ */
+
+static void _worker_thread(void *arg)
+{
+    GRAPHICS_CONTROLLER *gc = (GRAPHICS_CONTROLLER *)arg;
+    GC_WORKER           *w  = gc->worker;
+
+    bd_mutex_lock(&w->mutex);
+
+    while (1) {
+        GC_QUEUE_ITEM *item;
+        int            complete;
+
+        while (!w->head && !w->exit) {
+            bd_cond_wait(&w->cond, &w->mutex);
+        }
+        if (w->exit) {
+            break;
+        }
+
+        item = w->head;
+        w->head = item->next;
+        if (!w->head) {
+            w->tail = NULL;
+        }
+        w->count--;
+        w->busy = 1;
+        bd_cond_broadcast(&w->cond);
+        bd_mutex_unlock(&w->mutex);
+
+        complete = _decode_ts(gc, item->pid, item->block, item->num_blocks, -1) > 0;
+        if (complete && IS_HDMV_PID_PG(item->pid)) {
+            /* render subtitles */
+            gc_run(gc, GC_CTRL_PG_UPDATE, 0, NULL);
+        }
+
+        bd_mutex_lock(&w->mutex);
+        if (complete && IS_HDMV_PID_IG(item->pid)) {
+            /* menu initialization must be run in caller's thread */
+            w->ig_ready = 1;
+        }
+        w->busy = 0;
+        bd_cond_broadcast(&w->cond);
+        free(item);
+    }
+
+    bd_mutex_unlock(&w->mutex);
+}
+
+/* wait until worker is idle. Queued data is dropped if discard is set. */
+static void _worker_sync(GRAPHICS_CONTROLLER *gc, int discard)
+{
+    GC_WORKER *w = gc->worker;
+
+    if (!w) {
+        return;
+    }
+
+    bd_mutex_lock(&w->mutex);
+
+    if (discard) {
+        while (w->head) {
+            GC_QUEUE_ITEM *item = w->head;
+            w->head = item->next;
+            free(item);
+        }
+        w->tail     = NULL;
+        w->count    = 0;
+    }
+
+    while (w->head || w->busy) {
+        bd_cond_wait(&w->cond, &w->mutex);
+    }
+
+    if (discard) {
+        /* display set decoded before seek / reset is stale */
+        w->ig_ready = 0;
+    }
+
+    bd_mutex_unlock(&w->mutex);
+}
+
+int gc_set_async(GRAPHICS_CONTROLLER *gc, int enable)
+{
+    GC_WORKER *w;
+
+    if (!gc) {
+        return -1;
+    }
+
+    if (!enable) {
+        w = gc->worker;
+        if (w) {
+            _worker_sync(gc, 1);
+
+            bd_mutex_lock(&w->mutex);
+            w->exit = 1;
+            bd_cond_broadcast(&w->cond);
+            bd_mutex_unlock(&w->mutex);
+
+            bd_thread_join(&w->thread);
+
+            bd_cond_destroy(&w->cond);
+            bd_mutex_destroy(&w->mutex);
+            X_FREE(gc->worker);
+        }
+        return 0;
+    }
+
+    if (gc->worker) {
+        return 0;
+    }
+
+    w = calloc(1, sizeof(*w));
+    if (!w) {
+        GC_ERROR("gc_set_async(): out of memory\n");
+        return -1;
+    }
+    if (bd_mutex_init(&w->mutex) < 0) {
+        X_FREE(w);
+        return -1;
+    }
+    if (bd_cond_init(&w->cond) < 0) {
+        bd_mutex_destroy(&w->mutex);
+        X_FREE(w);
+        return -1;
+    }
+
+    gc->worker = w;
+
+    if (bd_thread_create(&w->thread, _worker_thread, gc)) {
+        GC_ERROR("gc_set_async(): failed creating decoder thread\n");
+        bd_cond_destroy(&w->cond);
+        bd_mutex_destroy(&w->mutex);
+        X_FREE(gc->worker);
+        return -1;
+    }
+
+    return 0;
+}
+
+int gc_decode_ts(GRAPHICS_CONTROLLER *gc, uint16_t pid, uint8_t *block, unsigned num_blocks, int64_t stc)
+{
+    if (!gc) {
+        GC_TRACE("gc_decode_ts(): no graphics controller\n");
+        return -1;
+    }
+
+    /* keep input order */
+    _worker_sync(gc, 0);
+
+    return _decode_ts(gc, pid, block, num_blocks, stc);
+}
+
+int gc_queue_ts(GRAPHICS_CONTROLLER *gc, uint16_t pid, uint8_t *block, unsigned num_blocks)
+{
+    GC_WORKER     *w;
+    GC_QUEUE_ITEM *item;
+    int            result;
+
+    if (!gc) {
+        GC_TRACE("gc_queue_ts(): no graphics controller\n");
+        return -1;
+    }
+
+    w = gc->worker;
+    if (!w) {
+        result = _decode_ts(gc, pid, block, num_blocks, -1);
+        if (result > 0 && IS_HDMV_PID_PG(pid)) {
+            /* render subtitles */
+            gc_run(gc, GC_CTRL_PG_UPDATE, 0, NULL);
+            return 0;
+        }
+        return result;
+    }
+
+    item = malloc(sizeof(*item) + (size_t)num_blocks * 6144);
+    if (!item) {
+        GC_ERROR("gc_queue_ts(): out of memory\n");
+        return -1;
+    }
+    item->next       = NULL;
+    item->pid        = pid;
+    item->num_blocks = num_blocks;
+    memcpy(item->block, block, (size_t)num_blocks * 6144);
+
+    bd_mutex_lock(&w->mutex);
+
+    while (w->count >= GC_QUEUE_MAX) {
+        bd_cond_wait(&w->cond, &w->mutex);
+    }
+
+    if (w->tail) {
+        w->tail->next = item;
+    } else {
+        w->head = item;
+    }
+    w->tail = item;
+    w->count++;
+    bd_cond_broadcast(&w->cond);
+
+    bd_mutex_unlock(&w->mutex);
+
+    /* completed menus are reported by gc_poll_menu_ready() */
+    return 0;
+}
+
+int gc_poll_menu_ready(GRAPHICS_CONTROLLER *gc)
+{
+    GC_WORKER *w;
+    int        result = 0;
+
+    if (!gc || !gc->worker) {
+        return 0;
+    }
+
+    w = gc->worker;
+
+    bd_mutex_lock(&w->mutex);
+    if (w->ig_ready) {
+        w->ig_ready = 0;
+        result = 1;
+    }
+    bd_mutex_unlock(&w->mutex);
+
+    return result;
+}
+
 /*
  * TextST rendering
  */
@@ -1016,12 +1657,54 @@ static int _render_textst_region(GRAPHICS_CONTROLLER *p, int64_t pts, BD_TEXTST_
     return 0;
 }
 
+static unsigned _textst_dialog_idx(PG_DISPLAY_SET *s, unsigned pos)
+{
+    return s->dialog_order ? s->dialog_order[pos] : pos;
+}
+
+/* find first dialog (in presentation order) that is visible at given time or starts later */
+static unsigned _find_textst_dialog(PG_DISPLAY_SET *s, int64_t now)
+{
+    unsigned lo, hi, mid, first;
+
+    if (!s->dialog_order) {
+        return 0;
+    }
+
+    /* first dialog starting after now */
+    lo = 0;
+    hi = s->num_dialog;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (s->dialog[s->dialog_order[mid]].start_pts <= now) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    first = lo;
+
+    /* scan back over dialogs that started earlier but are still visible */
+    lo = 0;
+    hi = first;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (s->dialog_end_max[mid] < now) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
 static int _render_textst(GRAPHICS_CONTROLLER *p, uint32_t stc, GC_NAV_CMDS *cmds)
 {
     BD_TEXTST_DIALOG_PRESENTATION *dialog = NULL;
     PG_DISPLAY_SET *s   = p->tgs;
     int64_t         now = ((int64_t)stc) << 1;
-    unsigned ii, jj;
+    unsigned pos, ii, jj;
 
     if (!s || !s->dialog || !s->style) {
         GC_ERROR("_render_textst(): no TextST decoded\n");
@@ -1034,8 +1717,16 @@ static int _render_textst(GRAPHICS_CONTROLLER *p, uint32_t stc, GC_NAV_CMDS *cmd
 
     dialog = s->dialog;
 
+    /* playback position changed (seek) ? */
+    if (p->next_dialog_idx < 0 && now >= 1) {
+        p->next_dialog_idx = _find_textst_dialog(s, now);
+        GC_TRACE("_render_textst(): continuing from dialog #%d\n", p->next_dialog_idx);
+    }
+
     /* loop over all matching dialogs */
-    for (ii = p->next_dialog_idx; ii < s->num_dialog; ii++) {
+    for (pos = BD_MAX(p->next_dialog_idx, 0); pos < s->num_dialog; pos++) {
+
+        ii = _textst_dialog_idx(s, pos);
 
         /* next dialog too far in future ? */
         if (now < 1 || dialog[ii].start_pts >= now + 90000) {
@@ -1047,13 +1738,9 @@ static int _render_textst(GRAPHICS_CONTROLLER *p, uint32_t stc, GC_NAV_CMDS *cmd
             return 1;
         }
 
-        p->next_dialog_idx = ii + 1;
+        p->next_dialog_idx = pos + 1;
 
-        /* too late ? */
-        if (dialog[ii].start_pts < now - 45000) {
-            GC_TRACE("_render_textst(): not showing #%d (start time passed)\n",ii);
-            continue;
-        }
+        /* too late ? (dialog that is still visible is shown, ex. after seek) */
         if (dialog[ii].end_pts < now) {
             GC_TRACE("_render_textst(): not showing #%d (hide time passed)\n",ii);
             continue;
@@ -1121,8 +1808,8 @@ static int _render_textst(GRAPHICS_CONTROLLER *p, uint32_t stc, GC_NAV_CMDS *cmd
         _flush_osd(p, BD_OVERLAY_PG, dialog[ii].start_pts);
 
         /* detect overlapping dialogs (not allowed) */
-        if (ii < s->num_dialog - 1) {
-            if (dialog[ii + 1].start_pts < dialog[ii].end_pts) {
+        if (pos < s->num_dialog - 1) {
+            if (dialog[_textst_dialog_idx(s, pos + 1)].start_pts < dialog[ii].end_pts) {
                 GC_ERROR("_render_textst: overlapping dialogs detected\n");
             }
         }
@@ -1253,7 +1940,7 @@ static void _reset_pg(GRAPHICS_CONTROLLER *gc)
         _close_osd(gc, BD_OVERLAY_PG);
     }
 
-    gc->next_dialog_idx = 0;
+    gc->next_dialog_idx = -1;
 }
 
 /*
@@ -1315,6 +2002,8 @@ static void _render_button(GRAPHICS_CONTROLLER *gc, BD_IG_BUTTON *button, BD_PG_
                    button->x_pos, button->y_pos,
                    object, palette);
 
+    gc->effect_palette_id = -1;
+
     bog_data->x = button->x_pos;
     bog_data->y = button->y_pos;
     bog_data->w = object->width;
@@ -1345,10 +2034,31 @@ static int _render_ig_composition_object(GRAPHICS_CONTROLLER *gc,
     return 0;
 }
 
+static int _rects_overlap(const EFFECT_OBJ *a, const EFFECT_OBJ *b)
+{
+    return !(a->cobj.x + a->w <= b->cobj.x        ||
+             a->cobj.x        >= b->cobj.x + b->w ||
+             a->cobj.y + a->h <= b->cobj.y        ||
+             a->cobj.y        >= b->cobj.y + b->h);
+}
+
+static int _effect_obj_equal(const EFFECT_OBJ *a, const EFFECT_OBJ *b)
+{
+    return a->cobj.object_id_ref == b->cobj.object_id_ref &&
+           a->cobj.x == b->cobj.x && a->cobj.y == b->cobj.y &&
+           a->w == b->w && a->h == b->h &&
+           a->cobj.crop_flag == b->cobj.crop_flag &&
+           (!a->cobj.crop_flag ||
+            (a->cobj.crop_x == b->cobj.crop_x && a->cobj.crop_y == b->cobj.crop_y));
+}
+
 static int _render_effect(GRAPHICS_CONTROLLER *gc, BD_IG_EFFECT *effect)
 {
     BD_PG_PALETTE *palette = NULL;
-    unsigned ii;
+    EFFECT_OBJ    *prev    = gc->effect_obj;
+    EFFECT_OBJ    *cur     = NULL;
+    unsigned       num_prev = gc->num_effect_obj;
+    unsigned       ii, jj, changed = 0;
     int64_t pts = -1;
 
     if (!gc->ig_open) {
@@ -1357,19 +2067,97 @@ static int _render_effect(GRAPHICS_CONTROLLER *gc, BD_IG_EFFECT *effect)
                   gc->igs->ics->video_descriptor.video_height);
     }
 
-    _clear_osd(gc, BD_OVERLAY_IG);
+    /* previous effect frame can be updated only if it was rendered using the same palette */
+    if (gc->effect_palette_id != effect->palette_id_ref) {
+        _clear_osd(gc, BD_OVERLAY_IG);
+        num_prev = 0;
+        changed  = 1;
+    }
+
+    gc->num_effect_obj    = 0;
+    gc->effect_palette_id = -1;
 
     palette = _find_palette(gc->igs, effect->palette_id_ref);
     if (!palette) {
         GC_ERROR("_render_effect: palette #%d not found\n", effect->palette_id_ref);
+        X_FREE(prev);
+        gc->effect_obj = NULL;
         return -1;
     }
 
+    if (effect->num_composition_objects) {
+        cur = calloc(effect->num_composition_objects, sizeof(*cur));
+        if (!cur) {
+            GC_ERROR("_render_effect: out of memory\n");
+            X_FREE(prev);
+            gc->effect_obj = NULL;
+            return -1;
+        }
+    }
+
+    for (ii = 0; ii < effect->num_composition_objects; ii++) {
+        BD_PG_COMPOSITION_OBJECT *cobj   = &effect->composition_object[ii];
+        BD_PG_OBJECT             *object = _find_object(gc->igs, cobj->object_id_ref);
+
+        cur[ii].cobj = *cobj;
+        if (!object) {
+            GC_ERROR("_render_effect: object #%d not found\n", cobj->object_id_ref);
+            continue;
+        }
+        cur[ii].w = cobj->crop_flag ? cobj->crop_w : object->width;
+        cur[ii].h = cobj->crop_flag ? cobj->crop_h : object->height;
+    }
+
+    /* wipe objects that changed or disappeared */
+    for (ii = 0; ii < num_prev; ii++) {
+        if (ii < effect->num_composition_objects && _effect_obj_equal(&prev[ii], &cur[ii])) {
+            continue;
+        }
+        if (prev[ii].w && prev[ii].h) {
+            _clear_osd_area(gc, BD_OVERLAY_IG, pts, prev[ii].cobj.x, prev[ii].cobj.y, prev[ii].w, prev[ii].h);
+            changed = 1;
+        }
+        /* mark as wiped */
+        prev[ii].cobj.object_id_ref = 0xffff;
+    }
+
+    /* draw changed objects, and unchanged objects hit by wipe or overdraw */
     for (ii = 0; ii < effect->num_composition_objects; ii++) {
+        int redraw = (ii >= num_prev || prev[ii].cobj.object_id_ref == 0xffff);
+
+        if (!cur[ii].w || !cur[ii].h) {
+            continue;
+        }
+
+        /* area was wiped ? */
+        for (jj = 0; jj < num_prev && !redraw; jj++) {
+            if (prev[jj].cobj.object_id_ref == 0xffff && prev[jj].w && _rects_overlap(&prev[jj], &cur[ii])) {
+                redraw = 1;
+            }
+        }
+        /* object below this one was redrawn ? */
+        for (jj = 0; jj < ii && !redraw; jj++) {
+            if (cur[jj].redrawn && _rects_overlap(&cur[jj], &cur[ii])) {
+                redraw = 1;
+            }
+        }
+        if (!redraw) {
+            continue;
+        }
+
         _render_ig_composition_object(gc, pts, &effect->composition_object[ii], palette);
+        cur[ii].redrawn = 1;
+        changed = 1;
     }
 
-    _flush_osd(gc, BD_OVERLAY_IG, pts);
+    X_FREE(prev);
+    gc->effect_obj        = cur;
+    gc->num_effect_obj    = effect->num_composition_objects;
+    gc->effect_palette_id = effect->palette_id_ref;
+
+    if (changed) {
+        _flush_osd(gc, BD_OVERLAY_IG, pts);
+    }
 
     _reset_user_timeout(gc);
 
@@ -1413,7 +2201,7 @@ static int _render_page(GRAPHICS_CONTROLLER *gc,
         gc->out_effects = NULL;
     }
 
-    page = _find_page(&s->ics->interactive_composition, page_id);
+    page = _find_page(s, page_id);
     if (!page) {
         GC_ERROR("_render_page: unknown page id %d (have %d pages)\n",
               page_id, s->ics->interactive_composition.num_pages);
@@ -1447,11 +2235,10 @@ static int _render_page(GRAPHICS_CONTROLLER *gc,
     }
 
     for (ii = 0; ii < page->num_bogs; ii++) {
-        BD_IG_BOG    *bog      = &page->bog[ii];
         unsigned      valid_id = gc->bog_data[ii].enabled_button;
         BD_IG_BUTTON *button;
 
-        button = _find_button_bog(bog, valid_id);
+        button = _find_button_bog(s, page, ii, valid_id);
 
         if (!button) {
             GC_TRACE("_render_page(): bog %d: button %d not found\n", ii, valid_id);
@@ -1557,7 +2344,7 @@ static int _user_input(GRAPHICS_CONTROLLER *gc, uint32_t key, GC_NAV_CMDS *cmds)
 
     GC_TRACE("_user_input(%d)\n", key);
 
-    page = _find_page(&s->ics->interactive_composition, page_id);
+    page = _find_page(s, page_id);
     if (!page) {
         GC_ERROR("_user_input(): unknown page id %d (have %d pages)\n",
               page_id, s->ics->interactive_composition.num_pages);
@@ -1573,9 +2360,8 @@ static int _user_input(GRAPHICS_CONTROLLER *gc, uint32_t key, GC_NAV_CMDS *cmds)
     }
 
     for (ii = 0; ii < page->num_bogs; ii++) {
-        BD_IG_BOG *bog      = &page->bog[ii];
         unsigned   valid_id = gc->bog_data[ii].enabled_button;
-        BD_IG_BUTTON *button = _find_button_bog(bog, valid_id);
+        BD_IG_BUTTON *button = _find_button_bog(s, page, ii, valid_id);
         if (!button) {
             continue;
         }
@@ -1619,7 +2405,7 @@ static int _user_input(GRAPHICS_CONTROLLER *gc, uint32_t key, GC_NAV_CMDS *cmds)
             }
 
             if (new_btn_id != cur_btn_id) {
-                BD_IG_BUTTON *new_button = _find_button_page(page, new_btn_id, NULL);
+                BD_IG_BUTTON *new_button = _find_button_page(s, page, new_btn_id, NULL);
                 if (new_button && cmds) {
                     cmds->sound_id_ref = new_button->selected_sound_id_ref;
                 }
@@ -1671,7 +2457,7 @@ static void _set_button_page(GRAPHICS_CONTROLLER *gc, uint32_t param)
             return;
         }
 
-        page = _find_page(&s->ics->interactive_composition, page_id);
+        page = _find_page(s, page_id);
 
         /* invalid page --> command is ignored */
         if (!page) {
@@ -1686,7 +2472,7 @@ static void _set_button_page(GRAPHICS_CONTROLLER *gc, uint32_t param)
     } else {
         /* page does not change */
         page_id = bd_psr_read(gc->regs, PSR_MENU_PAGE_ID);
-        page    = _find_page(&s->ics->interactive_composition, page_id);
+        page    = _find_page(s, page_id);
 
         if (!page) {
             GC_ERROR("_set_button_page(): PSR_MENU_PAGE_ID refers to unknown page %d\n", page_id);
@@ -1696,7 +2482,7 @@ static void _set_button_page(GRAPHICS_CONTROLLER *gc, uint32_t param)
 
     if (button_flag) {
         /* find correct button and overlap group */
-        button = _find_button_page(page, button_id, &bog_idx);
+        button = _find_button_page(s, page, button_id, &bog_idx);
 
         if (!page_flag) {
             if (!button) {
@@ -1714,6 +2500,7 @@ static void _set_button_page(GRAPHICS_CONTROLLER *gc, uint32_t param)
 
     if (button) {
         gc->bog_data[bog_idx].enabled_button = button_id;
+        gc->hit_grid.valid = 0;
         _select_button(gc, button_id);
     }
 
@@ -1731,7 +2518,7 @@ static void _enable_button(GRAPHICS_CONTROLLER *gc, uint32_t button_id, unsigned
 
     GC_TRACE("_enable_button(#%d, %s)\n", button_id, enable ? "enable" : "disable");
 
-    page = _find_page(&s->ics->interactive_composition, page_id);
+    page = _find_page(s, page_id);
     if (!page) {
         GC_TRACE("_enable_button(): unknown page #%d (have %d pages)\n",
               page_id, s->ics->interactive_composition.num_pages);
@@ -1739,7 +2526,7 @@ static void _enable_button(GRAPHICS_CONTROLLER *gc, uint32_t button_id, unsigned
     }
 
     /* find correct button overlap group */
-    button = _find_button_page(page, button_id, &bog_idx);
+    button = _find_button_page(s, page, button_id, &bog_idx);
     if (!button) {
         GC_TRACE("_enable_button(): unknown button #%d (page #%d)\n", button_id, page_id);
         return;
@@ -1752,10 +2539,12 @@ static void _enable_button(GRAPHICS_CONTROLLER *gc, uint32_t button_id, unsigned
         }
         gc->bog_data[bog_idx].enabled_button = button_id;
         gc->bog_data[bog_idx].animate_indx = 0;
+        gc->hit_grid.valid = 0;
 
     } else {
         if (gc->bog_data[bog_idx].enabled_button == button_id) {
             gc->bog_data[bog_idx].enabled_button = 0xffff;
+            gc->hit_grid.valid = 0;
         }
 
         if (cur_btn_id == button_id) {
@@ -1785,14 +2574,159 @@ static void _update_selected_button(GRAPHICS_CONTROLLER *gc)
     }
 }
 
+static void _hit_rect_cells(const HIT_GRID *grid, const HIT_RECT *r,
+                            unsigned *x0, unsigned *y0, unsigned *x1, unsigned *y1)
+{
+    *x0 = BD_MIN(r->x / grid->cell_w, HIT_GRID_COLS - 1);
+    *y0 = BD_MIN(r->y / grid->cell_h, HIT_GRID_ROWS - 1);
+    *x1 = BD_MIN(((unsigned)r->x + r->w - 1) / grid->cell_w, HIT_GRID_COLS - 1);
+    *y1 = BD_MIN(((unsigned)r->y + r->h - 1) / grid->cell_h, HIT_GRID_ROWS - 1);
+}
+
+static void _build_hit_grid(GRAPHICS_CONTROLLER *gc, BD_IG_PAGE *page)
+{
+    PG_DISPLAY_SET *s    = gc->igs;
+    HIT_GRID       *grid = &gc->hit_grid;
+    unsigned        width  = s->ics->video_descriptor.video_width;
+    unsigned        height = s->ics->video_descriptor.video_height;
+    unsigned        count[HIT_GRID_COLS * HIT_GRID_ROWS];
+    unsigned        ii, cx, cy, total = 0;
+
+    grid->valid  = 0;
+    grid->page   = page;
+    grid->cell_w = (width  + HIT_GRID_COLS - 1) / HIT_GRID_COLS;
+    grid->cell_h = (height + HIT_GRID_ROWS - 1) / HIT_GRID_ROWS;
+    if (!grid->cell_w) grid->cell_w = 1;
+    if (!grid->cell_h) grid->cell_h = 1;
+
+    memset(count, 0, sizeof(count));
+
+    /* collect selectable areas */
+    for (ii = 0; ii < page->num_bogs; ii++) {
+        HIT_RECT     *r        = &grid->rect[ii];
+        unsigned      valid_id = gc->bog_data[ii].enabled_button;
+        BD_IG_BUTTON *button   = _find_button_bog(s, page, ii, valid_id);
+        BD_PG_OBJECT *object   = NULL;
+
+        r->button = NULL;
+        r->w = r->h = 0;
+        if (button) {
+            /* SELECTED state object (button that can be selected) */
+            object = _find_object_for_button(s, button, BTN_SELECTED, NULL);
+        }
+        if (!object || !object->width || !object->height) {
+            continue;
+        }
+
+        r->button = button;
+        r->x = button->x_pos;
+        r->y = button->y_pos;
+        r->w = object->width;
+        r->h = object->height;
+    }
+
+    /* count cell entries */
+    for (ii = 0; ii < page->num_bogs; ii++) {
+        HIT_RECT *r = &grid->rect[ii];
+        unsigned  x0, x1, y0, y1;
+        if (!r->button) {
+            continue;
+        }
+        _hit_rect_cells(grid, r, &x0, &y0, &x1, &y1);
+        for (cy = y0; cy <= y1; cy++) {
+            for (cx = x0; cx <= x1; cx++) {
+                count[cy * HIT_GRID_COLS + cx]++;
+                total++;
+            }
+        }
+    }
+
+    if (total > grid->bog_size) {
+        uint8_t *tmp = realloc(grid->bog, total);
+        if (!tmp) {
+            GC_ERROR("_build_hit_grid(): out of memory\n");
+            return;
+        }
+        grid->bog      = tmp;
+        grid->bog_size = total;
+    }
+
+    grid->cell_start[0] = 0;
+    for (ii = 0; ii < HIT_GRID_COLS * HIT_GRID_ROWS; ii++) {
+        grid->cell_start[ii + 1] = grid->cell_start[ii] + count[ii];
+        count[ii] = grid->cell_start[ii];
+    }
+
+    /* fill cells in bog order (first matching bog wins) */
+    for (ii = 0; ii < page->num_bogs; ii++) {
+        HIT_RECT *r = &grid->rect[ii];
+        unsigned  x0, x1, y0, y1;
+        if (!r->button) {
+            continue;
+        }
+        _hit_rect_cells(grid, r, &x0, &y0, &x1, &y1);
+        for (cy = y0; cy <= y1; cy++) {
+            for (cx = x0; cx <= x1; cx++) {
+                grid->bog[count[cy * HIT_GRID_COLS + cx]++] = ii;
+            }
+        }
+    }
+
+    grid->valid = 1;
+}
+
+static BD_IG_BUTTON *_hit_test(GRAPHICS_CONTROLLER *gc, BD_IG_PAGE *page, unsigned x, unsigned y)
+{
+    HIT_GRID *grid = &gc->hit_grid;
+    unsigned  cell, ii;
+
+    if (!grid->valid || grid->page != page) {
+        _build_hit_grid(gc, page);
+    }
+
+    if (!grid->valid) {
+        /* no grid, check all buttons */
+        for (ii = 0; ii < page->num_bogs; ii++) {
+            unsigned      valid_id = gc->bog_data[ii].enabled_button;
+            BD_IG_BUTTON *button   = _find_button_bog(gc->igs, page, ii, valid_id);
+            BD_PG_OBJECT *object;
+
+            if (!button)
+                continue;
+            if (x < button->x_pos || y < button->y_pos)
+                continue;
+            /* Check for SELECTED state object (button that can be selected) */
+            object = _find_object_for_button(gc->igs, button, BTN_SELECTED, NULL);
+            if (!object)
+                continue;
+            if (x >= button->x_pos + object->width || y >= button->y_pos + object->height)
+                continue;
+            return button;
+        }
+        return NULL;
+    }
+
+    cell = BD_MIN(y / grid->cell_h, HIT_GRID_ROWS - 1) * HIT_GRID_COLS +
+           BD_MIN(x / grid->cell_w, HIT_GRID_COLS - 1);
+
+    for (ii = grid->cell_start[cell]; ii < grid->cell_start[cell + 1]; ii++) {
+        HIT_RECT *r = &grid->rect[grid->bog[ii]];
+        if (x >= r->x && y >= r->y && x < (unsigned)r->x + r->w && y < (unsigned)r->y + r->h) {
+            return r->button;
+        }
+    }
+
+    return NULL;
+}
+
 static int _mouse_move(GRAPHICS_CONTROLLER *gc, uint16_t x, uint16_t y, GC_NAV_CMDS *cmds)
 {
     PG_DISPLAY_SET *s          = gc->igs;
     BD_IG_PAGE     *page       = NULL;
+    BD_IG_BUTTON   *button     = NULL;
     unsigned        page_id    = bd_psr_read(gc->regs, PSR_MENU_PAGE_ID);
     unsigned        cur_btn_id = bd_psr_read(gc->regs, PSR_SELECTED_BUTTON_ID);
     unsigned        new_btn_id = 0xffff;
-    unsigned        ii;
 
     gc->valid_mouse_position = 0;
 
@@ -1806,32 +2740,15 @@ static int _mouse_move(GRAPHICS_CONTROLLER *gc, uint16_t x, uint16_t y, GC_NAV_C
         return -1;
     }
 
-    page = _find_page(&s->ics->interactive_composition, page_id);
+    page = _find_page(s, page_id);
     if (!page) {
         GC_ERROR("_mouse_move(): unknown page #%d (have %d pages)\n",
               page_id, s->ics->interactive_composition.num_pages);
         return -1;
     }
 
-    for (ii = 0; ii < page->num_bogs; ii++) {
-        BD_IG_BOG    *bog      = &page->bog[ii];
-        unsigned      valid_id = gc->bog_data[ii].enabled_button;
-        BD_IG_BUTTON *button   = _find_button_bog(bog, valid_id);
-
-        if (!button)
-            continue;
-
-        if (x < button->x_pos || y < button->y_pos)
-            continue;
-
-        /* Check for SELECTED state object (button that can be selected) */
-        BD_PG_OBJECT *object = _find_object_for_button(s, button, BTN_SELECTED, NULL);
-        if (!object)
-            continue;
-
-        if (x >= button->x_pos + object->width || y >= button->y_pos + object->height)
-            continue;
-
+    button = _hit_test(gc, page, x, y);
+    if (button) {
         /* mouse is over button */
         gc->valid_mouse_position = 1;
 
@@ -1845,8 +2762,6 @@ static int _mouse_move(GRAPHICS_CONTROLLER *gc, uint16_t x, uint16_t y, GC_NAV_C
         if (cmds) {
             cmds->sound_id_ref = button->selected_sound_id_ref;
         }
-
-        break;
     }
 
     if (new_btn_id != 0xffff) {
@@ -1956,6 +2871,11 @@ int gc_run(GRAPHICS_CONTROLLER *gc, gc_ctrl_e ctrl, uint32_t param, GC_NAV_CMDS
         return result;
     }
 
+    /* pending input is obsolete. Wait for decoder thread before touching decoder state. */
+    if (ctrl == GC_CTRL_RESET || ctrl == GC_CTRL_PG_RESET) {
+        _worker_sync(gc, 1);
+    }
+
     bd_mutex_lock(&gc->mutex);
 
     /* always accept reset */
@@ -33,6 +33,7 @@
 
 struct bd_registers_s;
 struct bd_overlay_s;
+struct bd_overlay_batch_s;
 
 /*
  * types
@@ -41,6 +42,7 @@ struct bd_overlay_s;
 typedef struct graphics_controller_s GRAPHICS_CONTROLLER;
 
 typedef void (*gc_overlay_proc_f)(void *, const struct bd_overlay_s * const);
+typedef void (*gc_overlay_batch_proc_f)(void *, const struct bd_overlay_batch_s * const);
 
 typedef enum {
     /* */
@@ -100,8 +102,22 @@ typedef struct {
 BD_PRIVATE GRAPHICS_CONTROLLER *gc_init(struct bd_registers_s *regs,
                                         void *handle, gc_overlay_proc_f func);
 
+/* overlay events are collected and delivered in batches (one call for each FLUSH) */
+BD_PRIVATE GRAPHICS_CONTROLLER *gc_init_batch(struct bd_registers_s *regs,
+                                              void *handle, gc_overlay_batch_proc_f func);
+
 BD_PRIVATE void                 gc_free(GRAPHICS_CONTROLLER **p);
 
+/**
+ *
+ *  Set overlay palette conversion
+ *
+ * @param p  GRAPHICS_CONTROLLER object
+ * @param format  BLURAY_PALETTE_* value (0 = disabled)
+ * @return 0 on success, -1 if format is not supported
+ */
+BD_PRIVATE int                  gc_set_palette_format(GRAPHICS_CONTROLLER *p, int format);
+
 /**
  *
  *  Decode data from MPEG-TS input stream
@@ -118,6 +134,46 @@ BD_PRIVATE int                  gc_decode_ts(GRAPHICS_CONTROLLER *p,
                                              uint8_t *block, unsigned num_blocks,
                                              int64_t stc);
 
+/**
+ *
+ *  Decode IG/PG data from main path MPEG-TS input stream
+ *
+ *  Completed PG compositions are rendered.
+ *  When background decoding is enabled, data is decoded in decoder thread.
+ *
+ * @param p  GRAPHICS_CONTROLLER object
+ * @param pid  mpeg-ts PID to decode (HDMV IG/PG stream)
+ * @param block  mpeg-ts data
+ * @param num_blocks  number of aligned units in data
+ * @return <0 on error, >0 when menus (IG) should be (re-)initialized, 0 otherwise
+ *         (with background decoding, see gc_poll_menu_ready())
+ */
+BD_PRIVATE int                  gc_queue_ts(GRAPHICS_CONTROLLER *p,
+                                            uint16_t pid,
+                                            uint8_t *block, unsigned num_blocks);
+
+/**
+ *
+ *  Check if IG display set was decoded in decoder thread
+ *
+ *  Menu initialization must be run in caller's thread. This should be polled
+ *  regularly (also when no stream data is read).
+ *
+ * @param p  GRAPHICS_CONTROLLER object
+ * @return >0 when menus (IG) should be (re-)initialized, 0 otherwise
+ */
+BD_PRIVATE int                  gc_poll_menu_ready(GRAPHICS_CONTROLLER *p);
+
+/**
+ *
+ *  Enable/disable background decoding of IG/PG streams
+ *
+ * @param p  GRAPHICS_CONTROLLER object
+ * @param enable  1 to start decoder thread, 0 to stop it
+ * @return <0 on error, 0 on success
+ */
+BD_PRIVATE int                  gc_set_async(GRAPHICS_CONTROLLER *p, int enable);
+
 /*
  * run graphics controller
  */
@@ -29,6 +29,7 @@
 #include "pes_buffer.h"
 #include "m2ts_demux.h"
 
+#include "util/refcnt.h"
 #include "util/macro.h"
 #include "util/logging.h"
 #include "util/bits.h"
@@ -70,11 +71,203 @@ static void _free_dialogs(PG_DISPLAY_SET *s)
         textst_clean_dialog_presentation(&s->dialog[ii]);
     }
     X_FREE(s->dialog);
+    X_FREE(s->dialog_order);
+    X_FREE(s->dialog_end_max);
 
     s->num_dialog = 0;
     s->total_dialog = 0;
 }
 
+/*
+ * lookup tables
+ */
+
+static void _free_index(PG_DISPLAY_SET *s)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < s->num_button_index; ii++) {
+        X_FREE(s->button_index[ii].button);
+        X_FREE(s->button_index[ii].bog);
+    }
+    X_FREE(s->button_index);
+    s->num_button_index = 0;
+
+    X_FREE(s->object_index);
+    s->object_index_size = 0;
+
+    s->index_valid = 0;
+}
+
+static int _build_button_index(PG_BUTTON_INDEX *bi, BD_IG_PAGE *page)
+{
+    unsigned ii, jj, max_id = 0;
+
+    for (ii = 0; ii < page->num_bogs; ii++) {
+        for (jj = 0; jj < page->bog[ii].num_buttons; jj++) {
+            if (page->bog[ii].button[jj].id > max_id) {
+                max_id = page->bog[ii].button[jj].id;
+            }
+        }
+    }
+
+    bi->size   = max_id + 1;
+    bi->button = calloc(bi->size, sizeof(bi->button[0]));
+    bi->bog    = calloc(bi->size, sizeof(bi->bog[0]));
+    if (!bi->button || !bi->bog) {
+        return -1;
+    }
+
+    /* first match wins (same as linear search) */
+    for (ii = page->num_bogs; ii-- > 0; ) {
+        BD_IG_BOG *bog = &page->bog[ii];
+        for (jj = bog->num_buttons; jj-- > 0; ) {
+            bi->button[bog->button[jj].id] = &bog->button[jj];
+            bi->bog[bog->button[jj].id]    = ii;
+        }
+    }
+
+    return 0;
+}
+
+static void _build_index(PG_DISPLAY_SET *s)
+{
+    unsigned ii, max_id = 0;
+
+    _free_index(s);
+    memset(s->palette_index, 0, sizeof(s->palette_index));
+    memset(s->page_index,    0, sizeof(s->page_index));
+
+    /* reverse order: first match wins (same as linear search) */
+    for (ii = s->num_palette; ii-- > 0; ) {
+        s->palette_index[s->palette[ii].id] = &s->palette[ii];
+    }
+
+    for (ii = 0; ii < s->num_object; ii++) {
+        if (s->object[ii].id > max_id) {
+            max_id = s->object[ii].id;
+        }
+    }
+    if (s->num_object) {
+        s->object_index = calloc(max_id + 1, sizeof(s->object_index[0]));
+        if (!s->object_index) {
+            goto oom;
+        }
+        s->object_index_size = max_id + 1;
+        for (ii = s->num_object; ii-- > 0; ) {
+            s->object_index[s->object[ii].id] = &s->object[ii];
+        }
+    }
+
+    if (s->ics) {
+        BD_IG_INTERACTIVE_COMPOSITION *c = &s->ics->interactive_composition;
+
+        for (ii = c->num_pages; ii-- > 0; ) {
+            s->page_index[c->page[ii].id] = &c->page[ii];
+        }
+
+        if (c->num_pages) {
+            s->button_index = calloc(c->num_pages, sizeof(s->button_index[0]));
+            if (!s->button_index) {
+                goto oom;
+            }
+            s->num_button_index = c->num_pages;
+            for (ii = 0; ii < c->num_pages; ii++) {
+                if (_build_button_index(&s->button_index[ii], &c->page[ii]) < 0) {
+                    goto oom;
+                }
+            }
+        }
+    }
+
+    s->index_valid = 1;
+    return;
+
+ oom:
+    BD_DEBUG(DBG_DECODE | DBG_CRIT, "out of memory\n");
+    _free_index(s);
+}
+
+/*
+ * object cache
+ */
+
+static uint32_t _hash(const uint8_t *data, uint32_t len)
+{
+    /* FNV-1a */
+    uint32_t h = 2166136261u;
+    uint32_t ii;
+    for (ii = 0; ii < len; ii++) {
+        h = (h ^ data[ii]) * 16777619u;
+    }
+    return h;
+}
+
+static void _free_object_cache(PG_DISPLAY_SET *s)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < PG_OBJECT_CACHE_SIZE; ii++) {
+        X_FREE(s->object_cache[ii].data);
+        refcnt_dec(s->object_cache[ii].img);
+        s->object_cache[ii].img = NULL;
+    }
+}
+
+/* decode object definition segment, re-use image of identical object */
+static int _decode_object_cached(PG_DISPLAY_SET *s, BITBUFFER *bb, BD_PG_OBJECT *obj)
+{
+    PG_OBJECT_CACHE_ENTRY *e;
+    const uint8_t *p    = bb->p;
+    const uint8_t *data = p + 7;  /* id(16) version(8) sequence descriptor(8) data_len(24) */
+    uint32_t       len, hash;
+    unsigned       ii;
+
+    if (bb->i_left != 8 || data + 4 > bb->p_end ||
+        (p[3] & 0xc0) != 0xc0 /* first and last in sequence */) {
+        return pg_decode_object(bb, obj);
+    }
+
+    len = bb->p_end - data;
+    if (len != ((uint32_t)p[4] << 16 | p[5] << 8 | p[6])) {
+        return pg_decode_object(bb, obj);
+    }
+    hash = _hash(data, len);
+
+    for (ii = 0; ii < PG_OBJECT_CACHE_SIZE; ii++) {
+        e = &s->object_cache[ii];
+        if (e->img && e->hash == hash && e->len == len && !memcmp(e->data, data, len)) {
+            obj->id      = p[0] << 8 | p[1];
+            obj->version = p[2];
+            obj->width   = data[0] << 8 | data[1];
+            obj->height  = data[2] << 8 | data[3];
+            /* shared image is never modified (objects are decoded to new buffer) */
+            obj->img     = (BD_PG_RLE_ELEM *)(uintptr_t)refcnt_inc(e->img);
+            return 1;
+        }
+    }
+
+    if (!pg_decode_object(bb, obj)) {
+        return 0;
+    }
+
+    /* add to cache */
+    e = &s->object_cache[s->object_cache_next];
+    X_FREE(e->data);
+    refcnt_dec(e->img);
+    e->img  = NULL;
+    e->data = malloc(len);
+    if (e->data) {
+        memcpy(e->data, data, len);
+        e->hash = hash;
+        e->len  = len;
+        e->img  = refcnt_inc(obj->img);
+        s->object_cache_next = (s->object_cache_next + 1) % PG_OBJECT_CACHE_SIZE;
+    }
+
+    return 1;
+}
+
 void pg_display_set_free(PG_DISPLAY_SET **s)
 {
     if (s && *s) {
@@ -84,6 +277,9 @@ void pg_display_set_free(PG_DISPLAY_SET **s)
         }
         ig_free_interactive(&(*s)->ics);
 
+        _free_index(*s);
+        _free_object_cache(*s);
+
         X_FREE((*s)->window);
         X_FREE((*s)->object);
         X_FREE((*s)->palette);
@@ -240,7 +436,14 @@ static int _decode_ods(PG_DISPLAY_SET *s, BITBUFFER *bb, PES_BUFFER *p)
 
         for (ii = 0; ii < s->num_object; ii++) {
             if (s->object[ii].id == id) {
-                if (pg_decode_object(bb, &s->object[ii])) {
+                if (!s->ics) {
+                    /* image may be shared, do not update in place */
+                    pg_clean_object(&s->object[ii]);
+                    if (_decode_object_cached(s, bb, &s->object[ii])) {
+                        s->object[ii].pts = p->pts;
+                        return 1;
+                    }
+                } else if (pg_decode_object(bb, &s->object[ii])) {
                     s->object[ii].pts = p->pts;
                     return 1;
                 }
@@ -260,7 +463,9 @@ static int _decode_ods(PG_DISPLAY_SET *s, BITBUFFER *bb, PES_BUFFER *p)
     s->object = tmp;
     memset(&s->object[s->num_object], 0, sizeof(s->object[0]));
 
-    if (pg_decode_object(bb, &s->object[s->num_object])) {
+    /* PG: re-use identical objects (IG objects are not cached) */
+    if (s->ics ? pg_decode_object(bb, &s->object[s->num_object])
+               : _decode_object_cached(s, bb, &s->object[s->num_object])) {
         s->object[s->num_object].pts = p->pts;
         s->num_object++;
         return 1;
@@ -444,6 +649,57 @@ static int _decode_dialog_style(PG_DISPLAY_SET *s, BITBUFFER *bb)
     return 1;
 }
 
+typedef struct {
+    int64_t  start_pts;
+    unsigned idx;
+} DIALOG_KEY;
+
+static int _dialog_key_cmp(const void *a, const void *b)
+{
+    const DIALOG_KEY *ka = a, *kb = b;
+
+    if (ka->start_pts != kb->start_pts) {
+        return ka->start_pts < kb->start_pts ? -1 : 1;
+    }
+    return ka->idx < kb->idx ? -1 : (ka->idx > kb->idx);
+}
+
+static void _build_dialog_index(PG_DISPLAY_SET *s)
+{
+    DIALOG_KEY *key;
+    unsigned    ii;
+
+    X_FREE(s->dialog_order);
+    X_FREE(s->dialog_end_max);
+
+    key               = calloc(s->num_dialog, sizeof(*key));
+    s->dialog_order   = calloc(s->num_dialog, sizeof(*s->dialog_order));
+    s->dialog_end_max = calloc(s->num_dialog, sizeof(*s->dialog_end_max));
+    if (!key || !s->dialog_order || !s->dialog_end_max) {
+        /* lookup falls back to stream order */
+        BD_DEBUG(DBG_DECODE | DBG_CRIT, "out of memory\n");
+        X_FREE(key);
+        X_FREE(s->dialog_order);
+        X_FREE(s->dialog_end_max);
+        return;
+    }
+
+    /* dialogs should be in presentation order already */
+    for (ii = 0; ii < s->num_dialog; ii++) {
+        key[ii].start_pts = s->dialog[ii].start_pts;
+        key[ii].idx       = ii;
+    }
+    qsort(key, s->num_dialog, sizeof(*key), _dialog_key_cmp);
+
+    for (ii = 0; ii < s->num_dialog; ii++) {
+        int64_t end_pts = s->dialog[key[ii].idx].end_pts;
+        s->dialog_order[ii]   = key[ii].idx;
+        s->dialog_end_max[ii] = (ii > 0) ? BD_MAX(s->dialog_end_max[ii - 1], end_pts) : end_pts;
+    }
+
+    X_FREE(key);
+}
+
 static int _decode_dialog_presentation(PG_DISPLAY_SET *s, BITBUFFER *bb)
 {
     if (!s->style || s->total_dialog < 1) {
@@ -463,6 +719,7 @@ static int _decode_dialog_presentation(PG_DISPLAY_SET *s, BITBUFFER *bb)
     s->num_dialog++;
 
     if (s->num_dialog == s->total_dialog) {
+        _build_dialog_index(s);
         s->complete = 1;
     }
 
@@ -476,6 +733,10 @@ static int _decode_segment(PG_DISPLAY_SET *s, PES_BUFFER *p)
 
     uint8_t type   =    bb_read(&bb, 8);
     /*uint16_t len = */ bb_read(&bb, 16);
+
+    /* display set is modified, lookup tables are rebuilt at end of display set */
+    s->index_valid = 0;
+
     switch (type) {
         case PGS_OBJECT:
             return _decode_ods(s, &bb, p);
@@ -500,6 +761,7 @@ static int _decode_segment(PG_DISPLAY_SET *s, PES_BUFFER *p)
             }
             s->complete = 1;
             s->decoding = 0;
+            _build_index(s);
             return 1;
 
         case TGS_DIALOG_STYLE:
@@ -636,3 +898,212 @@ int graphics_processor_decode_ts(GRAPHICS_PROCESSOR *p,
 
     return result;
 }
+
+/*
+ * display set index
+ */
+
+static int _index_add(GP_INDEX *idx, uint64_t pos, int64_t pts, int epoch_start)
+{
+    unsigned lo = 0, hi = idx->num_entries;
+
+    /* usually appended to end */
+    if (hi && idx->entry[hi - 1].pos < pos) {
+        lo = hi;
+    }
+    while (lo < hi) {
+        unsigned mid = (lo + hi) / 2;
+        if (idx->entry[mid].pos < pos) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < idx->num_entries && idx->entry[lo].pos == pos) {
+        /* already indexed */
+        return 0;
+    }
+
+    if (idx->num_entries >= idx->size) {
+        unsigned new_size = idx->size ? 2 * idx->size : 64;
+        GP_ENTRY_POINT *tmp = realloc(idx->entry, new_size * sizeof(*tmp));
+        if (!tmp) {
+            BD_DEBUG(DBG_DECODE | DBG_CRIT, "out of memory\n");
+            return 0;
+        }
+        idx->entry = tmp;
+        idx->size  = new_size;
+    }
+
+    memmove(&idx->entry[lo + 1], &idx->entry[lo], (idx->num_entries - lo) * sizeof(idx->entry[0]));
+    idx->entry[lo].pos         = pos;
+    idx->entry[lo].pts         = pts;
+    idx->entry[lo].epoch_start = !!epoch_start;
+    idx->num_entries++;
+
+    return 1;
+}
+
+static int64_t _parse_pts(const uint8_t *p)
+{
+    int64_t ts;
+    ts  = ((int64_t)(p[0] & 0x0E)) << 29;
+    ts |=  p[1]         << 22;
+    ts |= (p[2] & 0xFE) << 14;
+    ts |=  p[3]         <<  7;
+    ts |= (p[4] & 0xFE) >>  1;
+    return ts;
+}
+
+static void _index_add_unit(GP_INDEX *idx, uint64_t pos)
+{
+    unsigned lo = 0, hi = idx->num_units;
+
+    /* usually appended to end */
+    if (hi && idx->unit[hi - 1] < pos) {
+        lo = hi;
+    }
+    while (lo < hi) {
+        unsigned mid = (lo + hi) / 2;
+        if (idx->unit[mid] < pos) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < idx->num_units && idx->unit[lo] == pos) {
+        /* already indexed */
+        return;
+    }
+
+    if (idx->num_units >= idx->units_size) {
+        unsigned new_size = idx->units_size ? 2 * idx->units_size : 256;
+        uint64_t *tmp = realloc(idx->unit, new_size * sizeof(*tmp));
+        if (!tmp) {
+            BD_DEBUG(DBG_DECODE | DBG_CRIT, "out of memory\n");
+            return;
+        }
+        idx->unit       = tmp;
+        idx->units_size = new_size;
+    }
+
+    memmove(&idx->unit[lo + 1], &idx->unit[lo], (idx->num_units - lo) * sizeof(idx->unit[0]));
+    idx->unit[lo] = pos;
+    idx->num_units++;
+}
+
+int graphics_processor_index_scan(GP_INDEX *idx, uint16_t pid,
+                                  const uint8_t *unit, unsigned num_units,
+                                  uint64_t pos)
+{
+    unsigned ii, jj;
+    int      result = 0;
+
+    if (idx->pid != pid) {
+        graphics_processor_index_clear(idx);
+        idx->pid = pid;
+    }
+
+    for (ii = 0; ii < num_units; ii++, unit += 6144, pos += 6144) {
+        int has_pid = 0;
+
+        for (jj = 0; jj < 32; jj++) {
+            const uint8_t *ts  = unit + jj * 192 + 4;
+            const uint8_t *pes = ts + 4;
+            unsigned       hdr_len, state;
+            int64_t        pts = -1;
+
+            if (ts[0] != 0x47 || (((ts[1] & 0x1f) << 8) | ts[2]) != pid) {
+                continue;
+            }
+            if (!has_pid) {
+                has_pid = 1;
+                _index_add_unit(idx, pos);
+            }
+
+            /* start of PES packet ? */
+            if (!(ts[1] & 0x40) || !(ts[3] & 0x10)) {
+                continue;
+            }
+            if (ts[3] & 0x20) {
+                pes += ts[4] + 1;
+            }
+            if (pes + 9 > ts + 188 || pes[0] || pes[1] || pes[2] != 1 || pes[3] == 0xbf) {
+                continue;
+            }
+            hdr_len = 9 + pes[8];
+            if (pes + hdr_len + 11 > ts + 188) {
+                continue;
+            }
+            if (pes[7] & 0x80) {
+                pts = _parse_pts(pes + 9);
+            }
+
+            /* composition segment. composition_state is at same offset in PCS and ICS. */
+            pes += hdr_len;
+            if (pes[0] != PGS_PG_COMPOSITION && pes[0] != PGS_IG_COMPOSITION) {
+                continue;
+            }
+            state = pes[10] >> 6;
+            if (state == 2 /* epoch start */ || state == 1 /* acquisition point */) {
+                result += _index_add(idx, pos, pts, state == 2);
+            }
+        }
+    }
+
+    return result;
+}
+
+const GP_ENTRY_POINT *graphics_processor_index_find(const GP_INDEX *idx, uint64_t pos)
+{
+    unsigned lo = 0, hi = idx->num_entries;
+
+    while (lo < hi) {
+        unsigned mid = (lo + hi) / 2;
+        if (idx->entry[mid].pos <= pos) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo ? &idx->entry[lo - 1] : NULL;
+}
+
+static unsigned _index_unit_find(const GP_INDEX *idx, uint64_t pos)
+{
+    unsigned lo = 0, hi = idx->num_units;
+
+    /* first unit at or after pos */
+    while (lo < hi) {
+        unsigned mid = (lo + hi) / 2;
+        if (idx->unit[mid] < pos) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+unsigned graphics_processor_index_units(const GP_INDEX *idx, uint64_t start, uint64_t end,
+                                        const uint64_t **unit)
+{
+    unsigned first = _index_unit_find(idx, start);
+    unsigned last  = _index_unit_find(idx, end);
+
+    *unit = idx->unit ? idx->unit + first : NULL;
+    return last - first;
+}
+
+void graphics_processor_index_clear(GP_INDEX *idx)
+{
+    X_FREE(idx->entry);
+    idx->num_entries = 0;
+    idx->size        = 0;
+    idx->pid         = 0;
+
+    X_FREE(idx->unit);
+    idx->num_units  = 0;
+    idx->units_size = 0;
+}
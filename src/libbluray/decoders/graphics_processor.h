@@ -34,6 +34,23 @@ typedef struct graphics_processor_s GRAPHICS_PROCESSOR;
  * PG_DISPLAY_SET
  */
 
+/* decoded PG objects, shared between identical object definitions */
+#define PG_OBJECT_CACHE_SIZE 16
+
+typedef struct {
+    uint32_t              hash;
+    uint32_t              len;
+    uint8_t              *data;  /* object data (width, height, RLE) */
+    const BD_PG_RLE_ELEM *img;   /* decoded object (holds reference) */
+} PG_OBJECT_CACHE_ENTRY;
+
+/* button lookup table for IG page */
+typedef struct {
+    unsigned        size;       /* max button id + 1 */
+    BD_IG_BUTTON  **button;     /* [button id] */
+    uint8_t        *bog;        /* [button id] -> index of button overlap group */
+} PG_BUTTON_INDEX;
+
 typedef struct {
     int64_t       valid_pts;
     uint8_t       complete;     /* set complete: last decoded segment was END_OF_DISPLAY */
@@ -50,6 +67,10 @@ typedef struct {
     BD_PG_WINDOW  *window;
     BD_TEXTST_DIALOG_PRESENTATION *dialog;
 
+    /* TextST presentation index (built when all dialog segments are decoded) */
+    unsigned      *dialog_order;    /* dialog indices sorted by start_pts */
+    int64_t       *dialog_end_max;  /* max. end_pts of dialog_order[0...i] */
+
     /* only one of the following segments can be present */
     BD_IG_INTERACTIVE   *ics;
     BD_PG_COMPOSITION   *pcs;
@@ -57,6 +78,20 @@ typedef struct {
 
     uint8_t decoding; /* internal flag: PCS/ICS decoded, but no end of presentation seen yet */
 
+    /* direct lookup tables (id -> entry).
+     * Built when display set is completed, invalidated when next segment is decoded. */
+    uint8_t          index_valid;
+    BD_PG_PALETTE   *palette_index[256];
+    unsigned         object_index_size;  /* max object id + 1 */
+    BD_PG_OBJECT   **object_index;
+    BD_IG_PAGE      *page_index[256];
+    PG_BUTTON_INDEX *button_index;       /* one per ICS page (same order) */
+    unsigned         num_button_index;
+
+    /* recently decoded PG objects (kept over epochs) */
+    PG_OBJECT_CACHE_ENTRY object_cache[PG_OBJECT_CACHE_SIZE];
+    unsigned              object_cache_next;  /* next slot to replace */
+
 } PG_DISPLAY_SET;
 
 BD_PRIVATE void pg_display_set_free(PG_DISPLAY_SET **s);
@@ -89,4 +124,52 @@ graphics_processor_decode_ts(GRAPHICS_PROCESSOR *p,
                              uint16_t pid, uint8_t *unit, unsigned num_units,
                              int64_t stc);
 
+/*
+ * display set index
+ */
+
+typedef struct {
+    uint64_t pos;          /* position of aligned unit containing composition segment (bytes) */
+    int64_t  pts;          /* composition segment PTS */
+    uint8_t  epoch_start;  /* 1: epoch start, 0: acquisition point */
+} GP_ENTRY_POINT;
+
+typedef struct {
+    uint16_t        pid;
+    unsigned        num_entries;
+    unsigned        size;
+    GP_ENTRY_POINT *entry;  /* sorted by position */
+
+    /* aligned units containing packets of pid */
+    unsigned        num_units;
+    unsigned        units_size;
+    uint64_t       *unit;   /* sorted position */
+} GP_INDEX;
+
+/**
+ *
+ *  Add display set entry points (epoch start / acquisition point) from MPEG-TS data to index
+ *
+ *  Index is cleared if PID changes.
+ *
+ * @param idx  index
+ * @param pid  mpeg-ts PID (HDMV IG/PG stream)
+ * @param unit  mpeg-ts data
+ * @param num_units  number of aligned units in data
+ * @param pos  position of first aligned unit
+ * @return number of new entries
+ */
+BD_PRIVATE int graphics_processor_index_scan(GP_INDEX *idx, uint16_t pid,
+                                             const uint8_t *unit, unsigned num_units,
+                                             uint64_t pos);
+
+/* find last entry point at or before position. NULL if not found. */
+BD_PRIVATE const GP_ENTRY_POINT *graphics_processor_index_find(const GP_INDEX *idx, uint64_t pos);
+
+/* find indexed units in range [start, end). Returns number of units, *unit is set to first unit. */
+BD_PRIVATE unsigned graphics_processor_index_units(const GP_INDEX *idx, uint64_t start, uint64_t end,
+                                                   const uint64_t **unit);
+
+BD_PRIVATE void graphics_processor_index_clear(GP_INDEX *idx);
+
 #endif // _GRAPHICS_PROCESSOR_H_
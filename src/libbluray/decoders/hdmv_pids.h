@@ -24,6 +24,7 @@
  */
 
 #define HDMV_PID_PAT              0
+#define HDMV_PID_SIT              0x001f
 #define HDMV_PID_PMT              0x0100
 #define HDMV_PID_PCR              0x1001
 
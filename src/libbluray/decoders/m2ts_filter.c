@@ -201,6 +201,11 @@ void m2ts_filter_seek(M2TS_FILTER *p, uint32_t pat_packets, int64_t in_pts)
     p->pat_packets = pat_packets;
 }
 
+int m2ts_filter_active(M2TS_FILTER *p)
+{
+    return p->wipe_pid[0] || p->pat_packets;
+}
+
 static int _filter_es_pts(M2TS_FILTER *p, const uint8_t *buf, uint16_t pid)
 {
     unsigned tp_error       = buf[4+1] & 0x80;
@@ -52,5 +52,11 @@ BD_PRIVATE int m2ts_filter(M2TS_FILTER *, uint8_t *block);
  */
 BD_PRIVATE void  m2ts_filter_seek(M2TS_FILTER *, uint32_t pat_packets, int64_t in_pts);
 
+/*
+ * Check if filter may still modify data after in point
+ * (streams waiting for in timestamp, seek buffer).
+ */
+BD_PRIVATE int   m2ts_filter_active(M2TS_FILTER *);
+
 
 #endif // _M2TS_FILTER_H_
@@ -32,7 +32,7 @@ extern "C" {
 #include <stdint.h>
 
 /** Version number of the interface described in this file. */
-#define BD_OVERLAY_INTERFACE_VERSION 2
+#define BD_OVERLAY_INTERFACE_VERSION 3
 
 /**
  * Overlay plane
@@ -107,8 +107,25 @@ typedef struct bd_overlay_s {
     const BD_PG_PALETTE_ENTRY * palette; /**< overlay palette (256 entries) */
     const BD_PG_RLE_ELEM      * img;     /**< RLE-compressed overlay image */
 
+    const uint32_t * palette_argb; /**< overlay palette converted to ARGB (256 entries) or NULL.
+                                        See BLURAY_PLAYER_SETTING_OVERLAY_PALETTE. (interface version 3) */
+
 } BD_OVERLAY;
 
+/**
+ * Batch of YUV overlay events
+ *
+ * Contains all events of one overlay plane up to (and including) the next
+ * FLUSH event. INIT and CLOSE events are delivered immediately.
+ * Events and palettes are valid only during the callback.
+ * Images are already cropped.
+ */
+typedef struct bd_overlay_batch_s {
+    uint8_t            plane;    /**< Overlay plane (\ref bd_overlay_plane_e) */
+    unsigned           num_cmds; /**< Number of events */
+    const BD_OVERLAY * cmds;     /**< Events, in output order */
+} BD_OVERLAY_BATCH;
+
 /*
   RLE images are reference-counted. If application caches rle data for later use,
   it needs to use bd_refcnt_inc() and bd_refcnt_dec().
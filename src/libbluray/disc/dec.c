@@ -31,6 +31,7 @@
 #include "util/logging.h"
 #include "util/macro.h"
 #include "util/strutl.h"
+#include "util/trace.h"
 
 #include <string.h>
 
@@ -307,8 +308,14 @@ BD_DEC *dec_init(struct dec_dev *dev, BD_ENC_INFO *enc_info,
 
     /* init decoding libraries */
     /* BD+ won't help unless AACS works ... */
-    if (_libaacs_init(dec, dev, enc_info, keyfile_path)) {
+    int64_t trace = bd_trace_begin();
+    int     aacs  = _libaacs_init(dec, dev, enc_info, keyfile_path);
+    bd_trace_end(trace, "_libaacs_init", NULL);
+
+    if (aacs) {
+        trace = bd_trace_begin();
         _libbdplus_init(dec, dev, enc_info, regs, psr_read, psr_write);
+        bd_trace_end(trace, "_libbdplus_init", NULL);
     }
 
     if (!enc_info->aacs_handled) {
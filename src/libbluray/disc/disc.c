@@ -31,21 +31,54 @@
 #include "util/macro.h"
 #include "util/mutex.h"
 #include "util/strutl.h"
+#include "util/time.h"
+#include "util/trace.h"
 #include "file/file.h"
 #include "file/mount.h"
 #include "file/dirs.h"
 
 #include <ctype.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "udf_fs.h"
 
+#define STREAM_POOL_SIZE  4
+
+#define PROPERTIES_FLUSH_INTERVAL  (5 * 90000)  /* 5 seconds (bd_get_scr() ticks) */
+
+/* parsed files */
+typedef struct {
+    BD_MUTEX        mutex;
+    size_t          size;
+    struct {
+        char        name[11];
+        const void *data;
+    } *entry;
+} DISC_CACHE;
+
+/* disc image state shared by all handles of the same image */
+typedef struct disc_shared_s DISC_SHARED;
+struct disc_shared_s {
+    DISC_SHARED    *next;
+    char           *image_path;  /* canonical path */
+    unsigned        ref_count;   /* protected by bd_global_lock() */
+
+    void           *udf;         /* UDF file system */
+    DISC_CACHE      cache;       /* files parsed from disc image */
+};
+
+static DISC_SHARED *shared_list;  /* protected by bd_global_lock() */
+
+static void _cache_clean(DISC_CACHE *c, const char *name);
+
 struct bd_disc {
     BD_MUTEX  ovl_mutex;     /* protect access to overlay root */
-    BD_MUTEX  properties_mutex; /* protect access to properties file */
+    BD_MUTEX  properties_mutex; /* protect access to properties */
 
     char     *disc_root;     /* disc filesystem root (if disc is mounted) */
+    char     *device_path;   /* device / image given to disc_open() */
     char     *overlay_root;  /* overlay filesystem root (if set) */
 
     BD_DEC   *dec;
@@ -56,17 +89,26 @@ struct bd_disc {
     void        (*pf_fs_close)(void *);
 
     const char   *udf_volid;
-    char         *properties_file;  /* NULL if not yet used */
+    char          *properties_file;  /* NULL if not yet used */
+    BD_PROPERTIES *properties;       /* loaded on first use */
+    uint64_t       properties_flushed; /* time of last write */
 
     int8_t        avchd;  /* -1 - unknown. 0 - no. 1 - yes */
 
-    /* disc cache */
-    BD_MUTEX        cache_mutex;
-    size_t          cache_size;
+    /* pool of open stream handles */
+    BD_MUTEX        stream_mutex;
+    unsigned        stream_stamp;
     struct {
         char        name[11];
-        const void *data;
-    } *cache;
+        BD_FILE_H  *fp;
+        unsigned    stamp;  /* last use */
+    } stream_pool[STREAM_POOL_SIZE];
+
+    /* disc cache */
+    DISC_CACHE      cache;
+
+    /* shared disc image (NULL if not shared) */
+    DISC_SHARED    *shared;
 };
 
 /*
@@ -268,6 +310,150 @@ static BD_DIR_H *_combine_dirs(BD_DIR_H *ovl, BD_DIR_H *rom)
     return dp;
 }
 
+/*
+ * stream handle pool
+ */
+
+static void _stream_pool_flush(BD_DISC *p)
+{
+    unsigned i;
+
+    bd_mutex_lock(&p->stream_mutex);
+    for (i = 0; i < STREAM_POOL_SIZE; i++) {
+        if (p->stream_pool[i].fp) {
+            file_close(p->stream_pool[i].fp);
+            p->stream_pool[i].fp = NULL;
+        }
+    }
+    bd_mutex_unlock(&p->stream_mutex);
+}
+
+static BD_FILE_H *_stream_pool_get(BD_DISC *p, const char *file)
+{
+    BD_FILE_H *fp = NULL;
+    unsigned i;
+
+    bd_mutex_lock(&p->stream_mutex);
+    for (i = 0; i < STREAM_POOL_SIZE; i++) {
+        if (p->stream_pool[i].fp && !strcmp(p->stream_pool[i].name, file)) {
+            fp = p->stream_pool[i].fp;
+            p->stream_pool[i].fp = NULL;
+            break;
+        }
+    }
+    bd_mutex_unlock(&p->stream_mutex);
+
+    return fp;
+}
+
+/*
+ * shared disc images
+ */
+
+static void _shared_free(DISC_SHARED *s)
+{
+    if (s->udf) {
+        udf_image_close(s->udf);
+    }
+    _cache_clean(&s->cache, NULL);
+    bd_mutex_destroy(&s->cache.mutex);
+    X_FREE(s->image_path);
+    X_FREE(s);
+}
+
+/* add reference to already opened image. Call with bd_global_lock() held. */
+static DISC_SHARED *_shared_find(const char *path)
+{
+    DISC_SHARED *s;
+
+    for (s = shared_list; s; s = s->next) {
+        if (!strcmp(s->image_path, path)) {
+            s->ref_count++;
+            BD_DEBUG(DBG_FILE, "Sharing disc image %s (%u handles)\n", path, s->ref_count);
+            return s;
+        }
+    }
+    return NULL;
+}
+
+static DISC_SHARED *_shared_get(const char *image_path)
+{
+    DISC_SHARED *s, *other;
+    char        *path;
+
+    /* same image can be referenced with different paths */
+    path = file_path_canonical(image_path);
+    if (!path) {
+        path = str_dup(image_path);
+        if (!path) {
+            return NULL;
+        }
+    }
+
+    bd_global_lock();
+    s = _shared_find(path);
+    bd_global_unlock();
+    if (s) {
+        X_FREE(path);
+        return s;
+    }
+
+    /* open without holding the lock (slow disc I/O) */
+    s = calloc(1, sizeof(*s));
+    if (!s) {
+        X_FREE(path);
+        return NULL;
+    }
+    bd_mutex_init(&s->cache.mutex);
+    s->image_path = path;
+    s->udf        = udf_image_open(image_path, NULL, NULL);
+    if (!s->udf) {
+        _shared_free(s);
+        return NULL;
+    }
+
+    bd_global_lock();
+
+    /* opened by another handle meanwhile ? */
+    other = _shared_find(path);
+    if (!other) {
+        s->ref_count = 1;
+        s->next      = shared_list;
+        shared_list  = s;
+    }
+
+    bd_global_unlock();
+
+    if (other) {
+        _shared_free(s);
+        return other;
+    }
+    return s;
+}
+
+static void _shared_release(DISC_SHARED *s)
+{
+    DISC_SHARED **pp;
+
+    bd_global_lock();
+
+    if (--s->ref_count > 0) {
+        bd_global_unlock();
+        return;
+    }
+
+    for (pp = &shared_list; *pp; pp = &(*pp)->next) {
+        if (*pp == s) {
+            *pp = s->next;
+            break;
+        }
+    }
+
+    bd_global_unlock();
+
+    _shared_free(s);
+}
+
 /*
  * disc open / close
  */
@@ -278,7 +464,8 @@ static BD_DISC *_disc_init()
     if (p) {
         bd_mutex_init(&p->ovl_mutex);
         bd_mutex_init(&p->properties_mutex);
-        bd_mutex_init(&p->cache_mutex);
+        bd_mutex_init(&p->cache.mutex);
+        bd_mutex_init(&p->stream_mutex);
 
         /* default file access functions */
         p->fs_handle          = (void*)p;
@@ -305,11 +492,7 @@ static void _set_paths(BD_DISC *p, const char *device_path)
     }
 }
 
-BD_DISC *disc_open(const char *device_path,
-                   fs_access *p_fs,
-                   struct bd_enc_info *enc_info,
-                   const char *keyfile_path,
-                   void *regs, void *psr_read, void *psr_write)
+static BD_DISC *_disc_open_fs(const char *device_path, fs_access *p_fs)
 {
     BD_DISC *p = _disc_init();
 
@@ -328,7 +511,14 @@ BD_DISC *disc_open(const char *device_path,
     /* check if disc root directory can be opened. If not, treat it as device/image file. */
     BD_DIR_H *dp_img = device_path ? dir_open(device_path) : NULL;
     if (!dp_img) {
-        void *udf = udf_image_open(device_path, p_fs ? p_fs->fs_handle : NULL, p_fs ? p_fs->read_blocks : NULL);
+        void *udf;
+        if (device_path && !(p_fs && (p_fs->open_dir || p_fs->read_blocks))) {
+            /* image file: share with other handles */
+            p->shared = _shared_get(device_path);
+            udf = p->shared ? p->shared->udf : NULL;
+        } else {
+            udf = udf_image_open(device_path, p_fs ? p_fs->fs_handle : NULL, p_fs ? p_fs->read_blocks : NULL);
+        }
         if (!udf) {
             BD_DEBUG(DBG_FILE | DBG_CRIT, "failed opening UDF image %s\n", device_path);
         } else {
@@ -347,9 +537,44 @@ BD_DISC *disc_open(const char *device_path,
         BD_DEBUG(DBG_FILE, "%s does not seem to be image file or device node\n", device_path);
     }
 
-    struct dec_dev dev = { p->fs_handle, p->pf_file_open_bdrom, p, (file_openFp)disc_open_path, p->disc_root, device_path };
+    p->device_path = device_path ? str_dup(device_path) : NULL;
+
+    return p;
+}
+
+BD_DISC *disc_open_fs(const char *device_path, fs_access *p_fs)
+{
+    int64_t  trace = bd_trace_begin();
+    BD_DISC *p = _disc_open_fs(device_path, p_fs);
+    bd_trace_end(trace, "disc_open_fs", device_path);
+    return p;
+}
+
+void disc_open_dec(BD_DISC *p,
+                   struct bd_enc_info *enc_info,
+                   const char *keyfile_path,
+                   void *regs, void *psr_read, void *psr_write)
+{
+    struct dec_dev dev = { p->fs_handle, p->pf_file_open_bdrom, p, (file_openFp)disc_open_path, p->disc_root, p->device_path };
+    int64_t trace = bd_trace_begin();
     p->dec = dec_init(&dev, enc_info, keyfile_path, regs, psr_read, psr_write);
+    bd_trace_end(trace, "disc_open_dec", NULL);
+}
 
+BD_DISC *disc_open(const char *device_path,
+                   fs_access *p_fs,
+                   struct bd_enc_info *enc_info,
+                   const char *keyfile_path,
+                   void *regs, void *psr_read, void *psr_write)
+{
+    int64_t  trace = bd_trace_begin();
+    BD_DISC *p = disc_open_fs(device_path, p_fs);
+
+    if (p) {
+        disc_open_dec(p, enc_info, keyfile_path, regs, psr_read, psr_write);
+    }
+
+    bd_trace_end(trace, "disc_open", device_path);
     return p;
 }
 
@@ -358,19 +583,30 @@ void disc_close(BD_DISC **pp)
     if (pp && *pp) {
         BD_DISC *p = *pp;
 
+        _stream_pool_flush(p);
+
+        if (p->properties) {
+            properties_flush(p->properties);
+            properties_free(&p->properties);
+        }
+
         dec_close(&p->dec);
 
-        if (p->pf_fs_close) {
+        if (p->shared) {
+            _shared_release(p->shared);
+        } else if (p->pf_fs_close) {
             p->pf_fs_close(p->fs_handle);
         }
 
-        disc_cache_clean(p, NULL);
+        _cache_clean(&p->cache, NULL);
 
         bd_mutex_destroy(&p->ovl_mutex);
         bd_mutex_destroy(&p->properties_mutex);
-        bd_mutex_destroy(&p->cache_mutex);
+        bd_mutex_destroy(&p->cache.mutex);
+        bd_mutex_destroy(&p->stream_mutex);
 
         X_FREE(p->disc_root);
+        X_FREE(p->device_path);
         X_FREE(p->properties_file);
         X_FREE(*pp);
     }
@@ -532,6 +768,9 @@ void disc_update(BD_DISC *p, const char *overlay_root)
     }
 
     bd_mutex_unlock(&p->ovl_mutex);
+
+    /* pooled streams may have been opened from old overlay */
+    _stream_pool_flush(p);
 }
 
 int disc_cache_bdrom_file(BD_DISC *p, const char *rel_path, const char *cache_path)
@@ -653,27 +892,44 @@ static char *_properties_file(BD_DISC *p)
     return properties_file;
 }
 
-static int _ensure_properties_file(BD_DISC *p)
+/* must be called with properties_mutex locked */
+static BD_PROPERTIES *_ensure_properties(BD_DISC *p)
 {
-    bd_mutex_lock(&p->properties_mutex);
-    if (!p->properties_file) {
-        p->properties_file = _properties_file(p);
+    if (!p->properties) {
+        if (!p->properties_file) {
+            p->properties_file = _properties_file(p);
+            if (!p->properties_file) {
+                return NULL;
+            }
+        }
+        p->properties = properties_load(p->properties_file);
+        p->properties_flushed = bd_get_scr();
     }
-    bd_mutex_unlock(&p->properties_mutex);
 
-    return p->properties_file ? 0 : -1;
+    return p->properties;
 }
 
 int disc_property_put(BD_DISC *p, const char *property, const char *val)
 {
-    int result;
+    BD_PROPERTIES *props;
+    int result = -1;
 
-    if (_ensure_properties_file(p) < 0) {
-        return -1;
+    bd_mutex_lock(&p->properties_mutex);
+
+    props = _ensure_properties(p);
+    if (props) {
+        result = properties_put(props, property, val);
+
+        /* batch writes: flush at most once in PROPERTIES_FLUSH_INTERVAL (rest is written in disc_close()) */
+        if (result == 0 && properties_dirty(props)) {
+            uint64_t now = bd_get_scr();
+            if (now - p->properties_flushed >= PROPERTIES_FLUSH_INTERVAL) {
+                properties_flush(props);
+                p->properties_flushed = now;
+            }
+        }
     }
 
-    bd_mutex_lock(&p->properties_mutex);
-    result = properties_put(p->properties_file, property, val);
     bd_mutex_unlock(&p->properties_mutex);
 
     return result;
@@ -681,14 +937,16 @@ int disc_property_put(BD_DISC *p, const char *property, const char *val)
 
 char *disc_property_get(BD_DISC *p, const char *property)
 {
-    char *result;
+    BD_PROPERTIES *props;
+    char *result = NULL;
 
-    if (_ensure_properties_file(p) < 0) {
-        return NULL;
+    bd_mutex_lock(&p->properties_mutex);
+
+    props = _ensure_properties(p);
+    if (props) {
+        result = properties_get(props, property);
     }
 
-    bd_mutex_lock(&p->properties_mutex);
-    result = properties_get(p->properties_file, property);
     bd_mutex_unlock(&p->properties_mutex);
 
     return result;
@@ -700,7 +958,16 @@ char *disc_property_get(BD_DISC *p, const char *property)
 
 BD_FILE_H *disc_open_stream(BD_DISC *disc, const char *file)
 {
-    BD_FILE_H *fp = disc_open_file(disc, "BDMV" DIR_SEP "STREAM", file);
+    BD_FILE_H *fp = _stream_pool_get(disc, file);
+    if (fp) {
+        if (file_seek(fp, 0, SEEK_SET) == 0) {
+            BD_DEBUG(DBG_FILE, "disc_open_stream: re-using %s (%p)\n", file, (void*)fp);
+            return fp;
+        }
+        file_close(fp);
+    }
+
+    fp = disc_open_file(disc, "BDMV" DIR_SEP "STREAM", file);
     if (!fp) {
         return NULL;
     }
@@ -715,6 +982,62 @@ BD_FILE_H *disc_open_stream(BD_DISC *disc, const char *file)
     return fp;
 }
 
+void disc_close_stream(BD_DISC *disc, const char *file, BD_FILE_H *fp)
+{
+    BD_FILE_H *evict = NULL;
+    unsigned i, lru = 0;
+
+    if (!fp) {
+        return;
+    }
+    if (strlen(file) >= sizeof(disc->stream_pool[0].name)) {
+        file_close(fp);
+        return;
+    }
+
+    bd_mutex_lock(&disc->stream_mutex);
+
+    /* use free slot or replace least recently used handle */
+    for (i = 0; i < STREAM_POOL_SIZE; i++) {
+        if (!disc->stream_pool[i].fp) {
+            lru = i;
+            break;
+        }
+        if (disc->stream_pool[i].stamp < disc->stream_pool[lru].stamp) {
+            lru = i;
+        }
+    }
+
+    evict = disc->stream_pool[lru].fp;
+    strcpy(disc->stream_pool[lru].name, file);
+    disc->stream_pool[lru].fp    = fp;
+    disc->stream_pool[lru].stamp = ++disc->stream_stamp;
+
+    bd_mutex_unlock(&disc->stream_mutex);
+
+    if (evict) {
+        file_close(evict);
+    }
+}
+
+void disc_prefetch_stream(BD_DISC *disc, const char *file, int64_t offset, int64_t size)
+{
+    BD_FILE_H *fp = disc_open_file(disc, "BDMV" DIR_SEP "STREAM", file);
+    if (!fp) {
+        return;
+    }
+
+    BD_DEBUG(DBG_FILE, "prefetch %s: %" PRId64 " bytes at %" PRId64 "\n", file, size, offset);
+
+    /* encryption does not change file layout: hint the raw file */
+    if (disc->pf_fs_close == udf_image_close) {
+        udf_file_prefetch(disc->fs_handle, fp, offset, size);
+    }
+    file_prefetch(fp, offset, size);
+
+    file_close(fp);
+}
+
 const uint8_t *disc_get_data(BD_DISC *disc, int type)
 {
     if (disc->dec) {
@@ -841,28 +1164,28 @@ int disc_pseudo_id(BD_DISC *p, uint8_t *id/*[20]*/)
  *
  */
 
-const void *disc_cache_get(BD_DISC *p, const char *name)
+static const void *_cache_get(DISC_CACHE *c, const char *name)
 {
     const void *data = NULL;
 
-    bd_mutex_lock(&p->cache_mutex);
-    if (p->cache) {
+    bd_mutex_lock(&c->mutex);
+    if (c->entry) {
         size_t i;
-        for (i = 0; p->cache[i].data; i++) {
-            if (!strcmp(p->cache[i].name, name)) {
-                data = refcnt_inc(p->cache[i].data);
+        for (i = 0; c->entry[i].data; i++) {
+            if (!strcmp(c->entry[i].name, name)) {
+                data = refcnt_inc(c->entry[i].data);
                 break;
             }
         }
     }
-    bd_mutex_unlock(&p->cache_mutex);
+    bd_mutex_unlock(&c->mutex);
 
     return data;
 }
 
-void disc_cache_put(BD_DISC *p, const char *name, const void *data)
+static void _cache_put(DISC_CACHE *c, const char *name, const void *data)
 {
-    if (strlen(name) >= sizeof(p->cache[0].name)) {
+    if (strlen(name) >= sizeof(c->entry[0].name)) {
         BD_DEBUG(DBG_FILE|DBG_CRIT, "disc_cache_put: key %s too large\n", name);
         return;
     }
@@ -871,34 +1194,34 @@ void disc_cache_put(BD_DISC *p, const char *name, const void *data)
         return;
     }
 
-    bd_mutex_lock(&p->cache_mutex);
+    bd_mutex_lock(&c->mutex);
 
-    if (!p->cache) {
-        p->cache_size = 128;
-        p->cache = calloc(p->cache_size, sizeof(*p->cache));
+    if (!c->entry) {
+        c->size = 128;
+        c->entry = calloc(c->size, sizeof(*c->entry));
     }
 
-    if (p->cache && p->cache[p->cache_size - 2].data) {
-        void *tmp = realloc(p->cache, 2 * p->cache_size * sizeof(p->cache[0]));
+    if (c->entry && c->entry[c->size - 2].data) {
+        void *tmp = realloc(c->entry, 2 * c->size * sizeof(c->entry[0]));
         if (tmp) {
-            p->cache = tmp;
-            memset(&p->cache[p->cache_size], 0, p->cache_size * sizeof(p->cache[0]));
-            p->cache_size *= 2;
+            c->entry = tmp;
+            memset(&c->entry[c->size], 0, c->size * sizeof(c->entry[0]));
+            c->size *= 2;
         }
     }
 
-    if (p->cache && !p->cache[p->cache_size - 2].data) {
+    if (c->entry && !c->entry[c->size - 2].data) {
         size_t i;
-        for (i = 0; p->cache[i].data; i++) {
-            if (!strcmp(p->cache[i].name, name)) {
+        for (i = 0; c->entry[i].data; i++) {
+            if (!strcmp(c->entry[i].name, name)) {
                 BD_DEBUG(DBG_FILE|DBG_CRIT, "disc_cache_put(): duplicate key %s\n", name);
-                refcnt_dec(p->cache[i].data);
+                refcnt_dec(c->entry[i].data);
                 break;
             }
         }
-        strcpy(p->cache[i].name, name);
-        p->cache[i].data = refcnt_inc(data);
-        if (p->cache[i].data) {
+        strcpy(c->entry[i].name, name);
+        c->entry[i].data = refcnt_inc(data);
+        if (c->entry[i].data) {
             BD_DEBUG(DBG_FILE, "disc_cache_put: added %s (%p)\n", name, data);
         } else {
             BD_DEBUG(DBG_FILE|DBG_CRIT, "disc_cache_put: error adding %s (%p): Invalid object type\n", name, data);
@@ -907,34 +1230,65 @@ void disc_cache_put(BD_DISC *p, const char *name, const void *data)
         BD_DEBUG(DBG_FILE|DBG_CRIT, "disc_cache_put: error adding %s (%p): Out of memory\n", name, data);
     }
 
-    bd_mutex_unlock(&p->cache_mutex);
+    bd_mutex_unlock(&c->mutex);
 }
 
-void disc_cache_clean(BD_DISC *p, const char *name)
+static void _cache_clean(DISC_CACHE *c, const char *name)
 {
-    bd_mutex_lock(&p->cache_mutex);
+    bd_mutex_lock(&c->mutex);
 
-    if (p->cache) {
+    if (c->entry) {
         size_t i;
         if (name == NULL) {
-            for (i = 0; p->cache[i].data; i++) {
-                refcnt_dec(p->cache[i].data);
+            for (i = 0; c->entry[i].data; i++) {
+                refcnt_dec(c->entry[i].data);
             }
-            X_FREE(p->cache);
-            p->cache_size = 0;
+            X_FREE(c->entry);
+            c->size = 0;
         } else {
-            for (i = 0; p->cache[i].data; i++) {
-                if (!strcmp(p->cache[i].name, name)) {
-                    BD_DEBUG(DBG_FILE, "disc_cache_clean: dropped %s (%p)\n", name, p->cache[i].data);
-                    refcnt_dec(p->cache[i].data);
+            for (i = 0; c->entry[i].data; i++) {
+                if (!strcmp(c->entry[i].name, name)) {
+                    BD_DEBUG(DBG_FILE, "disc_cache_clean: dropped %s (%p)\n", name, c->entry[i].data);
+                    refcnt_dec(c->entry[i].data);
                     break;
                 }
             }
-            for (; p->cache[i].data; i++) {
-                p->cache[i] = p->cache[i + 1];
+            for (; c->entry[i].data; i++) {
+                c->entry[i] = c->entry[i + 1];
             }
         }
     }
 
-    bd_mutex_unlock(&p->cache_mutex);
+    bd_mutex_unlock(&c->mutex);
+}
+
+/* shared cache can't be used when files may come from overlay (BD-J VFS) */
+static DISC_CACHE *_cache(BD_DISC *p)
+{
+    DISC_CACHE *c = &p->cache;
+
+    if (p->shared) {
+        bd_mutex_lock(&p->ovl_mutex);
+        if (!p->overlay_root) {
+            c = &p->shared->cache;
+        }
+        bd_mutex_unlock(&p->ovl_mutex);
+    }
+
+    return c;
+}
+
+const void *disc_cache_get(BD_DISC *p, const char *name)
+{
+    return _cache_get(_cache(p), name);
+}
+
+void disc_cache_put(BD_DISC *p, const char *name, const void *data)
+{
+    _cache_put(_cache(p), name, data);
+}
+
+void disc_cache_clean(BD_DISC *p, const char *name)
+{
+    _cache_clean(_cache(p), name);
 }
@@ -55,6 +55,14 @@ BD_PRIVATE BD_DISC *disc_open(const char *device_path,
                               const char *keyfile_path,
                               void *regs, void *psr_read, void *psr_write);
 
+/* Staged open: disc_open() == disc_open_fs() + disc_open_dec().
+ * Unencrypted files can be accessed while disc_open_dec() is running. */
+BD_PRIVATE BD_DISC *disc_open_fs(const char *device_path, fs_access *p_fs);
+BD_PRIVATE void     disc_open_dec(BD_DISC *disc,
+                                  struct bd_enc_info *enc_info,
+                                  const char *keyfile_path,
+                                  void *regs, void *psr_read, void *psr_write);
+
 BD_PRIVATE void     disc_close(BD_DISC **);
 
 /* Get BD-ROM root path */
@@ -95,6 +103,12 @@ BD_PRIVATE struct bd_dir_s  *disc_open_bdrom_dir(BD_DISC *disc, const char *path
 
 BD_PRIVATE struct bd_file_s *disc_open_stream(BD_DISC *disc, const char *file);
 
+/* Release stream handle. Handle is kept open for re-use. */
+BD_PRIVATE void disc_close_stream(BD_DISC *disc, const char *file, struct bd_file_s *fp);
+
+/* Hint: stream file range will be read soon */
+BD_PRIVATE void disc_prefetch_stream(BD_DISC *disc, const char *file, int64_t offset, int64_t size);
+
 /*
  * Store / fetch persistent properties for disc.
  * Data is stored in cache directory and persists between playback sessions.
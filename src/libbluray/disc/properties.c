@@ -26,11 +26,16 @@
 #include "file/file.h"
 #include "util/logging.h"
 #include "util/macro.h"
+#include "util/mutex.h"
 #include "util/strutl.h"
 
 #ifdef _WIN32
 /* mingw: PRId64 requires stdio.h ... */
 #include <stdio.h>
+#include <process.h>  /* _getpid() */
+#define getpid _getpid
+#else
+#include <unistd.h>   /* getpid() */
 #endif
 
 #include <stdlib.h>
@@ -98,6 +103,18 @@ static int _read_prop_file(const char *file, char **data)
     return *data ? 0 : -1;
 }
 
+static char *_tmp_file_name(const char *file)
+{
+    static unsigned counter;  /* protected by bd_global_lock() */
+    unsigned        seq;
+
+    bd_global_lock();
+    seq = counter++;
+    bd_global_unlock();
+
+    return str_printf("%s.%d.%u.tmp", file, (int)getpid(), seq);
+}
+
 static int _write_prop_file(const char *file, const char *data)
 {
     BD_FILE_H *fp;
@@ -134,101 +151,306 @@ static int _write_prop_file(const char *file, const char *data)
 }
 
 /*
- *
+ * in-memory map
  */
 
-static char *_scan_prop(char *data, const char *key, size_t *data_size)
+typedef struct {
+    char    *key;
+    char    *val;
+    uint8_t  dirty;   /* modified after load */
+} PROP_ENTRY;
+
+struct bd_properties {
+    char       *file;
+    unsigned    count;
+    unsigned    size;
+    PROP_ENTRY *entries;
+    uint8_t     dirty;
+};
+
+static PROP_ENTRY *_find_prop(BD_PROPERTIES *p, const char *key)
 {
-    size_t key_size = strlen(key);
-
-    while (data) {
-        if (!strncmp(data, key, key_size)) {
-            data += key_size;
-            char *lf = strchr(data, '\n');
-            *data_size = lf ? (size_t)(lf - data) : strlen(data);
-            return data;
-        }
+    unsigned ii;
 
-        /* next line */
-        data = strchr(data, '\n');
-        if (data) {
-            data++;
+    for (ii = 0; ii < p->count; ii++) {
+        if (!strcmp(p->entries[ii].key, key)) {
+            return &p->entries[ii];
         }
     }
 
     return NULL;
 }
 
-char *properties_get(const char *file, const char *property)
+static PROP_ENTRY *_add_prop(BD_PROPERTIES *p, const char *key)
 {
-    char *key, *data;
-    size_t data_size;
-    char *result = NULL;
+    PROP_ENTRY *e;
+
+    if (p->count >= p->size) {
+        unsigned new_size = p->size ? 2 * p->size : 8;
+        PROP_ENTRY *tmp = realloc(p->entries, new_size * sizeof(PROP_ENTRY));
+        if (!tmp) {
+            BD_DEBUG(DBG_CRIT, "out of memory\n");
+            return NULL;
+        }
+        p->entries = tmp;
+        p->size = new_size;
+    }
 
-    if (strchr(property, '\n') || strchr(property, '=')) {
-        BD_DEBUG(DBG_FILE | DBG_CRIT, "Ignoring invalid property '%s'\n", property);
+    e = &p->entries[p->count];
+    memset(e, 0, sizeof(*e));
+    e->key = str_dup(key);
+    if (!e->key) {
         return NULL;
     }
 
-    if (_read_prop_file(file, &data) < 0) {
-        return NULL;
+    p->count++;
+    return e;
+}
+
+static int _set_prop(BD_PROPERTIES *p, const char *key, const char *val)
+{
+    PROP_ENTRY *e = _find_prop(p, key);
+    char *new_val;
+
+    if (e && !strcmp(e->val, val)) {
+        return 0;
     }
 
-    key = str_printf("%s=", property);
-    if (!key) {
-        X_FREE(data);
-        return NULL;
+    new_val = str_dup(val);
+    if (!new_val) {
+        return -1;
+    }
+
+    if (!e) {
+        e = _add_prop(p, key);
+        if (!e) {
+            X_FREE(new_val);
+            return -1;
+        }
     }
 
-    result = _scan_prop(data, key, &data_size);
-    if (result) {
-        result[data_size] = 0;
-        result = str_dup(result);
+    X_FREE(e->val);
+    e->val = new_val;
+    e->dirty = 1;
+    return 0;
+}
+
+static void _clear_props(BD_PROPERTIES *p)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < p->count; ii++) {
+        X_FREE(p->entries[ii].key);
+        X_FREE(p->entries[ii].val);
     }
+    X_FREE(p->entries);
+    p->count = p->size = 0;
+}
 
-    X_FREE(key);
+/* parse "key=value\n" lines */
+static int _parse_props(BD_PROPERTIES *p, char *data)
+{
+    while (data && *data) {
+        char *lf = strchr(data, '\n');
+        char *eq;
+
+        if (lf) {
+            *lf = 0;
+        }
+
+        eq = strchr(data, '=');
+        if (eq) {
+            *eq = 0;
+            if (!_find_prop(p, data) && _set_prop(p, data, eq + 1) < 0) {
+                return -1;
+            }
+        }
+
+        data = lf ? lf + 1 : NULL;
+    }
+
+    return 0;
+}
+
+static int _load_props(BD_PROPERTIES *p)
+{
+    char *data;
+    unsigned ii;
+    int result;
+
+    if (_read_prop_file(p->file, &data) < 0) {
+        return -1;
+    }
+
+    result = _parse_props(p, data);
     X_FREE(data);
+
+    for (ii = 0; ii < p->count; ii++) {
+        p->entries[ii].dirty = 0;
+    }
+
     return result;
 }
 
-int properties_put(const char *file, const char *property, const char *val)
+static char *_serialize_props(BD_PROPERTIES *p)
 {
-    char *key = NULL, *old_data = NULL, *new_data = NULL;
-    char *old_val;
-    size_t old_size;
-    int result = -1;
+    unsigned ii;
+    size_t size = 1;
+    char *data, *d;
+
+    for (ii = 0; ii < p->count; ii++) {
+        size += strlen(p->entries[ii].key) + strlen(p->entries[ii].val) + 2;
+    }
+
+    data = d = malloc(size);
+    if (!data) {
+        return NULL;
+    }
 
-    if (strchr(property, '\n') || strchr(property, '=') || strchr(val, '\n')) {
+    for (ii = 0; ii < p->count; ii++) {
+        size_t key_len = strlen(p->entries[ii].key);
+        size_t val_len = strlen(p->entries[ii].val);
+        memcpy(d, p->entries[ii].key, key_len); d += key_len;
+        *d++ = '=';
+        memcpy(d, p->entries[ii].val, val_len); d += val_len;
+        *d++ = '\n';
+    }
+    *d = 0;
+
+    return data;
+}
+
+static int _valid_key(const char *property)
+{
+    return !strchr(property, '\n') && !strchr(property, '=');
+}
+
+/*
+ *
+ */
+
+BD_PROPERTIES *properties_load(const char *file)
+{
+    BD_PROPERTIES *p = calloc(1, sizeof(BD_PROPERTIES));
+    if (!p) {
+        return NULL;
+    }
+
+    p->file = str_dup(file);
+    if (!p->file || _load_props(p) < 0) {
+        properties_free(&p);
+        return NULL;
+    }
+
+    return p;
+}
+
+void properties_free(BD_PROPERTIES **pp)
+{
+    if (pp && *pp) {
+        _clear_props(*pp);
+        X_FREE((*pp)->file);
+        X_FREE(*pp);
+    }
+}
+
+char *properties_get(BD_PROPERTIES *p, const char *property)
+{
+    PROP_ENTRY *e;
+
+    if (!_valid_key(property)) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "Ignoring invalid property '%s'\n", property);
+        return NULL;
+    }
+
+    e = _find_prop(p, property);
+    return e ? str_dup(e->val) : NULL;
+}
+
+int properties_put(BD_PROPERTIES *p, const char *property, const char *val)
+{
+    if (!_valid_key(property) || strchr(val, '\n')) {
         BD_DEBUG(DBG_FILE | DBG_CRIT, "Ignoring invalid property '%s'='%s'\n", property, val);
-        goto out;
+        return -1;
     }
 
-    if (_read_prop_file(file, &old_data) < 0) {
-        goto out;
+    if (_set_prop(p, property, val) < 0) {
+        return -1;
     }
 
-    key = str_printf("%s=", property);
-    if (!key) {
-        goto out;
+    p->dirty |= _find_prop(p, property)->dirty;
+    return 0;
+}
+
+int properties_dirty(BD_PROPERTIES *p)
+{
+    return p->dirty;
+}
+
+int properties_flush(BD_PROPERTIES *p)
+{
+    BD_PROPERTIES *disk;
+    char *data, *tmp_file;
+    unsigned ii;
+    int result = -1;
+
+    if (!p->dirty) {
+        return 0;
     }
 
-    old_val = _scan_prop(old_data, key, &old_size);
-    if (!old_val) {
-        new_data = str_printf("%s%s%s\n", old_data, key, val);
-    } else {
-        *old_val = 0;
-        new_data = str_printf("%s%s%s", old_data, val, old_val + old_size);
+    /* merge with current file content: file may be shared with other players */
+    disk = properties_load(p->file);
+    if (!disk) {
+        return -1;
+    }
+    for (ii = 0; ii < p->count; ii++) {
+        if (p->entries[ii].dirty) {
+            if (_set_prop(disk, p->entries[ii].key, p->entries[ii].val) < 0) {
+                goto out;
+            }
+        }
+    }
+    /* adopt merged map */
+    for (ii = 0; ii < disk->count; ii++) {
+        PROP_ENTRY *e = _find_prop(p, disk->entries[ii].key);
+        if (!e || !e->dirty) {
+            if (_set_prop(p, disk->entries[ii].key, disk->entries[ii].val) < 0) {
+                goto out;
+            }
+        }
     }
 
-    if (!new_data) {
+    data = _serialize_props(disk);
+    if (!data) {
         goto out;
     }
 
-    result = _write_prop_file(file, new_data);
+    /* write to temporary file and replace atomically.
+     * File name must be unique between processes sharing the properties file. */
+    tmp_file = _tmp_file_name(p->file);
+    if (tmp_file) {
+        if (_write_prop_file(tmp_file, data) < 0) {
+            /* error already logged */
+        } else if (file_rename(tmp_file, p->file) < 0) {
+            BD_DEBUG(DBG_FILE | DBG_CRIT, "Error replacing properties file %s\n", p->file);
+            if (file_unlink(tmp_file) < 0) {
+                BD_DEBUG(DBG_FILE, "Error removing temporary properties file %s\n", tmp_file);
+            }
+        } else {
+            result = 0;
+        }
+        X_FREE(tmp_file);
+    }
+    X_FREE(data);
+
+    if (result == 0) {
+        for (ii = 0; ii < p->count; ii++) {
+            p->entries[ii].dirty = 0;
+        }
+        p->dirty = 0;
+    }
 
  out:
-    X_FREE(old_data);
-    X_FREE(new_data);
-    X_FREE(key);
+    properties_free(&disk);
     return result;
 }
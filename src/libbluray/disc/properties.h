@@ -30,26 +30,65 @@
  * property value: UTF-8 string, no '\n'
  */
 
+typedef struct bd_properties BD_PROPERTIES;
+
 /**
  *
- *  Add / replace property value in file.
+ *  Load properties file to memory.
  *
  * @param file  full path to properties file
+ * @return properties map, NULL on error
+ */
+BD_PRIVATE BD_PROPERTIES *properties_load(const char *file);
+
+/**
+ *
+ *  Free properties map. Pending changes are not written.
+ *
+ * @param p  properties map
+ */
+BD_PRIVATE void properties_free(BD_PROPERTIES **p);
+
+/**
+ *
+ *  Add / replace property value.
+ *  Change is stored to file in next properties_flush().
+ *
+ * @param p  properties map
  * @param property  property name
  * @param val  value for property
  * @return 0 on success, -1 on error
  */
-BD_PRIVATE int properties_put(const char *file, const char *property, const char *val);
+BD_PRIVATE int properties_put(BD_PROPERTIES *p, const char *property, const char *val);
 
 /**
  *
- *  Read property value from file.
+ *  Read property value.
  *
- * @param file  full path to properties file
+ * @param p  properties map
  * @param property  property name
- * @return property value or NULL
+ * @return property value (allocated) or NULL
+ */
+BD_PRIVATE char *properties_get(BD_PROPERTIES *p, const char *property);
+
+/**
+ *
+ *  Check for unwritten changes.
+ *
+ * @param p  properties map
+ * @return 1 if there are pending changes
+ */
+BD_PRIVATE int properties_dirty(BD_PROPERTIES *p);
+
+/**
+ *
+ *  Write pending changes to file.
+ *  Changes are merged with current file content and file is replaced atomically.
+ *
+ * @param p  properties map
+ * @return 0 on success, -1 on error
  */
-BD_PRIVATE char *properties_get(const char *file, const char *property);
+BD_PRIVATE int properties_flush(BD_PROPERTIES *p);
 
 
 #endif /* _BD_PROPERTIES_H_ */
@@ -0,0 +1,287 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "udf_cache.h"
+
+#include "util/macro.h"
+#include "util/mutex.h"
+#include "util/logging.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define UDF_CACHE_SHARDS 8
+
+typedef struct {
+    uint32_t lba;
+    int32_t  hash_next;   /* next entry in hash bucket */
+    int32_t  prev, next;  /* LRU list (unpinned entries only) */
+    uint8_t  pinned;
+} CACHE_ENTRY;
+
+typedef struct {
+    BD_MUTEX     mutex;
+    int          mutex_ok;    /* mutex initialized */
+
+    unsigned     size;        /* number of entries */
+    unsigned     num_used;
+    unsigned     num_pinned;
+
+    CACHE_ENTRY *entry;
+    uint8_t     *data;        /* UDF_CACHE_BLOCK_SIZE bytes / entry */
+
+    unsigned     hash_size;   /* power of 2 */
+    int32_t     *bucket;
+
+    int32_t      lru_head;    /* most recently used */
+    int32_t      lru_tail;    /* eviction candidate */
+} CACHE_SHARD;
+
+struct udf_cache_s {
+    CACHE_SHARD shard[UDF_CACHE_SHARDS];
+};
+
+/*
+ * shard
+ */
+
+static CACHE_SHARD *_shard(UDF_CACHE *p, uint32_t lba)
+{
+    /* spread consecutive sectors over shards */
+    return &p->shard[(lba * 2654435761u) >> 29];
+}
+
+static unsigned _hash(const CACHE_SHARD *s, uint32_t lba)
+{
+    return (lba * 2246822519u) & (s->hash_size - 1);
+}
+
+static void _lru_unlink(CACHE_SHARD *s, int32_t idx)
+{
+    CACHE_ENTRY *e = &s->entry[idx];
+
+    if (e->prev >= 0) {
+        s->entry[e->prev].next = e->next;
+    } else {
+        s->lru_head = e->next;
+    }
+    if (e->next >= 0) {
+        s->entry[e->next].prev = e->prev;
+    } else {
+        s->lru_tail = e->prev;
+    }
+    e->prev = e->next = -1;
+}
+
+static void _lru_push(CACHE_SHARD *s, int32_t idx)
+{
+    CACHE_ENTRY *e = &s->entry[idx];
+
+    e->prev = -1;
+    e->next = s->lru_head;
+    if (s->lru_head >= 0) {
+        s->entry[s->lru_head].prev = idx;
+    } else {
+        s->lru_tail = idx;
+    }
+    s->lru_head = idx;
+}
+
+static void _hash_remove(CACHE_SHARD *s, int32_t idx)
+{
+    int32_t *p = &s->bucket[_hash(s, s->entry[idx].lba)];
+
+    while (*p >= 0) {
+        if (*p == idx) {
+            *p = s->entry[idx].hash_next;
+            return;
+        }
+        p = &s->entry[*p].hash_next;
+    }
+}
+
+static int32_t _find(CACHE_SHARD *s, uint32_t lba)
+{
+    int32_t idx = s->bucket[_hash(s, lba)];
+
+    while (idx >= 0 && s->entry[idx].lba != lba) {
+        idx = s->entry[idx].hash_next;
+    }
+    return idx;
+}
+
+/* pin entry (if pin budget allows) */
+static void _pin(CACHE_SHARD *s, int32_t idx)
+{
+    if (!s->entry[idx].pinned && s->num_pinned < s->size / 2) {
+        _lru_unlink(s, idx);
+        s->entry[idx].pinned = 1;
+        s->num_pinned++;
+    }
+}
+
+static int _shard_init(CACHE_SHARD *s, unsigned size)
+{
+    unsigned ii;
+
+    s->size      = size;
+    s->hash_size = 1;
+    while (s->hash_size < size) {
+        s->hash_size <<= 1;
+    }
+
+    s->entry  = calloc(size, sizeof(*s->entry));
+    s->data   = malloc((size_t)size * UDF_CACHE_BLOCK_SIZE);
+    s->bucket = malloc(s->hash_size * sizeof(*s->bucket));
+    if (!s->entry || !s->data || !s->bucket) {
+        return -1;
+    }
+
+    for (ii = 0; ii < s->hash_size; ii++) {
+        s->bucket[ii] = -1;
+    }
+    s->lru_head = s->lru_tail = -1;
+
+    if (bd_mutex_init(&s->mutex) < 0) {
+        return -1;
+    }
+    s->mutex_ok = 1;
+    return 0;
+}
+
+static void _shard_free(CACHE_SHARD *s)
+{
+    if (s->mutex_ok) {
+        bd_mutex_destroy(&s->mutex);
+    }
+    X_FREE(s->entry);
+    X_FREE(s->data);
+    X_FREE(s->bucket);
+}
+
+/*
+ *
+ */
+
+UDF_CACHE *udf_cache_init(unsigned num_blocks)
+{
+    UDF_CACHE *p;
+    unsigned   ii;
+    unsigned   shard_size = num_blocks / UDF_CACHE_SHARDS;
+
+    if (shard_size < 4) {
+        return NULL;
+    }
+
+    p = calloc(1, sizeof(*p));
+    if (!p) {
+        return NULL;
+    }
+
+    for (ii = 0; ii < UDF_CACHE_SHARDS; ii++) {
+        if (_shard_init(&p->shard[ii], shard_size) < 0) {
+            BD_DEBUG(DBG_FILE | DBG_CRIT, "udf_cache_init(): initialization failed\n");
+            udf_cache_free(&p);
+            return NULL;
+        }
+    }
+
+    BD_DEBUG(DBG_FILE, "UDF sector cache: %u blocks\n", shard_size * UDF_CACHE_SHARDS);
+    return p;
+}
+
+void udf_cache_free(UDF_CACHE **p)
+{
+    if (p && *p) {
+        unsigned ii;
+        for (ii = 0; ii < UDF_CACHE_SHARDS; ii++) {
+            _shard_free(&(*p)->shard[ii]);
+        }
+        X_FREE(*p);
+    }
+}
+
+int udf_cache_get(UDF_CACHE *p, uint32_t lba, void *buf)
+{
+    CACHE_SHARD *s = _shard(p, lba);
+    int32_t      idx;
+
+    bd_mutex_lock(&s->mutex);
+
+    idx = _find(s, lba);
+    if (idx >= 0) {
+        memcpy(buf, s->data + (size_t)idx * UDF_CACHE_BLOCK_SIZE, UDF_CACHE_BLOCK_SIZE);
+
+        /* re-read sectors are file system metadata: keep them */
+        _pin(s, idx);
+        if (!s->entry[idx].pinned) {
+            _lru_unlink(s, idx);
+            _lru_push(s, idx);
+        }
+    }
+
+    bd_mutex_unlock(&s->mutex);
+
+    return idx >= 0;
+}
+
+void udf_cache_put(UDF_CACHE *p, uint32_t lba, const void *buf, int pin)
+{
+    CACHE_SHARD *s = _shard(p, lba);
+    int32_t      idx;
+    unsigned     h;
+
+    bd_mutex_lock(&s->mutex);
+
+    idx = _find(s, lba);
+    if (idx < 0) {
+        if (s->num_used < s->size) {
+            idx = (int32_t)s->num_used++;
+        } else {
+            /* evict least recently used sector */
+            idx = s->lru_tail;
+            if (idx < 0) {
+                bd_mutex_unlock(&s->mutex);
+                return;
+            }
+            _lru_unlink(s, idx);
+            _hash_remove(s, idx);
+        }
+
+        h = _hash(s, lba);
+        s->entry[idx].lba       = lba;
+        s->entry[idx].pinned    = 0;
+        s->entry[idx].hash_next = s->bucket[h];
+        s->bucket[h] = idx;
+
+        memcpy(s->data + (size_t)idx * UDF_CACHE_BLOCK_SIZE, buf, UDF_CACHE_BLOCK_SIZE);
+
+        _lru_push(s, idx);
+    }
+
+    if (pin) {
+        _pin(s, idx);
+    }
+
+    bd_mutex_unlock(&s->mutex);
+}
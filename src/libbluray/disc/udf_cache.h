@@ -0,0 +1,48 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BD_UDF_CACHE_H_
+#define _BD_UDF_CACHE_H_
+
+#include "util/attributes.h"
+
+#include <stdint.h>
+
+/*
+ * UDF sector cache
+ *
+ * Caches file system metadata (2048-byte sectors). File data is not cached.
+ * Sectors are spread over independently locked shards.
+ * Pinned sectors are never evicted.
+ */
+
+#define UDF_CACHE_BLOCK_SIZE 2048
+
+typedef struct udf_cache_s UDF_CACHE;
+
+BD_PRIVATE UDF_CACHE *udf_cache_init(unsigned num_blocks);
+BD_PRIVATE void       udf_cache_free(UDF_CACHE **p);
+
+/* copy cached sector to buf. Return 1 if found, 0 if not cached. */
+BD_PRIVATE int        udf_cache_get(UDF_CACHE *p, uint32_t lba, void *buf);
+
+/* add sector to cache. If pin is set, sector is never evicted. */
+BD_PRIVATE void       udf_cache_put(UDF_CACHE *p, uint32_t lba, const void *buf, int pin);
+
+#endif /* _BD_UDF_CACHE_H_ */
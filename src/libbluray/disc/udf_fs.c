@@ -22,6 +22,7 @@
 #endif
 
 #include "udf_fs.h"
+#include "udf_cache.h"
 
 #include "file/file.h"
 #include "util/macro.h"
@@ -41,6 +42,25 @@
 #include <string.h>
 #include <inttypes.h>
 
+typedef struct udf_ci_s UDF_CI;
+
+typedef struct {
+    udfread                    *udf;
+    struct udfread_block_input *bi;   /* our block input (NULL if image I/O is handled by libudfread or application) */
+    UDF_CI                     *ci;   /* sector cache (NULL if disabled) */
+    BD_MUTEX                    mutex; /* serialize path lookups (disc open runs in multiple threads) */
+} UDF_FS;
+
+typedef struct {
+    UDFFILE *fp;
+    UDF_FS  *fs;
+} UDF_FILE;
+
+/* block input read flag: file data, do not cache */
+#define UDF_READ_NOCACHE 0x1000
+
+static int _bi_prefetch(struct udfread_block_input *bi_gen, uint32_t lba, uint32_t nblocks);
+
 /*
  * file access
  */
@@ -48,33 +68,84 @@
 static void _file_close(BD_FILE_H *file)
 {
     if (file) {
-        udfread_file_close((UDFFILE*)file->internal);
+        udfread_file_close(((UDF_FILE*)file->internal)->fp);
         BD_DEBUG(DBG_FILE, "Closed UDF file (%p)\n", (void*)file);
+        X_FREE(file->internal);
         X_FREE(file);
     }
 }
 
 static int64_t _file_seek(BD_FILE_H *file, int64_t offset, int32_t origin)
 {
-    return udfread_file_seek((UDFFILE*)file->internal, offset, origin);
+    return udfread_file_seek(((UDF_FILE*)file->internal)->fp, offset, origin);
 }
 
 static int64_t _file_tell(BD_FILE_H *file)
 {
-    return udfread_file_tell((UDFFILE*)file->internal);
+    return udfread_file_tell(((UDF_FILE*)file->internal)->fp);
 }
 
 static int64_t _file_read(BD_FILE_H *file, uint8_t *buf, int64_t size)
 {
-    return udfread_file_read((UDFFILE*)file->internal, buf, size);
+    UDF_FILE *f = (UDF_FILE*)file->internal;
+    uint8_t   tmp[UDF_BLOCK_SIZE];
+    int64_t   pos, got = 0;
+    uint32_t  block, offset, n;
+
+    if (!f->fs->ci) {
+        return udfread_file_read(f->fp, buf, size);
+    }
+
+    /* file data is read only once: read blocks with a flag that keeps them out of the sector cache */
+
+    pos = udfread_file_tell(f->fp);
+    if (pos < 0 || size <= 0) {
+        return size == 0 ? 0 : -1;
+    }
+    size = BD_MIN(size, udfread_file_size(f->fp) - pos);
+
+    while (got < size) {
+        block  = (uint32_t)((pos + got) / UDF_BLOCK_SIZE);
+        offset = (uint32_t)((pos + got) % UDF_BLOCK_SIZE);
+
+        if (!offset && size - got >= UDF_BLOCK_SIZE) {
+            n = udfread_read_blocks(f->fp, buf + got, block, (uint32_t)BD_MIN((size - got) / UDF_BLOCK_SIZE, 1024), UDF_READ_NOCACHE);
+            if (!n) {
+                break;
+            }
+            got += (int64_t)n * UDF_BLOCK_SIZE;
+        } else {
+            if (udfread_read_blocks(f->fp, tmp, block, 1, UDF_READ_NOCACHE) != 1) {
+                break;
+            }
+            n = (uint32_t)BD_MIN(UDF_BLOCK_SIZE - offset, size - got);
+            memcpy(buf + got, tmp + offset, n);
+            got += n;
+        }
+    }
+
+    if (!got && size > 0) {
+        /* inline (embedded) file data or read error */
+        return udfread_file_read(f->fp, buf, size);
+    }
+
+    udfread_file_seek(f->fp, pos + got, SEEK_SET);
+    return got;
 }
 
-BD_FILE_H *udf_file_open(void *udf, const char *filename)
+BD_FILE_H *udf_file_open(void *fs, const char *filename)
 {
+    UDF_FS  *p = (UDF_FS *)fs;
+    UDF_FILE *f;
     BD_FILE_H *file = calloc(1, sizeof(BD_FILE_H));
     if (!file) {
         return NULL;
     }
+    f = calloc(1, sizeof(UDF_FILE));
+    if (!f) {
+        X_FREE(file);
+        return NULL;
+    }
 
     BD_DEBUG(DBG_FILE, "Opening UDF file %s... (%p)\n", filename, (void*)file);
 
@@ -85,15 +156,51 @@ BD_FILE_H *udf_file_open(void *udf, const char *filename)
     file->tell  = _file_tell;
     file->eof   = NULL;
 
-    file->internal = udfread_file_open((udfread*)udf, filename);
-    if (!file->internal) {
+    bd_mutex_lock(&p->mutex);
+    f->fp = udfread_file_open(p->udf, filename);
+    bd_mutex_unlock(&p->mutex);
+    if (!f->fp) {
         BD_DEBUG(DBG_FILE, "Error opening file %s!\n", filename);
+        X_FREE(f);
         X_FREE(file);
+        return NULL;
     }
 
+    f->fs = p;
+    file->internal = f;
+
     return file;
 }
 
+void udf_file_prefetch(void *fs, BD_FILE_H *file, int64_t offset, int64_t size)
+{
+    UDF_FS  *p = (UDF_FS *)fs;
+    uint32_t block, end, lba, nblocks;
+
+    /* ignore files from other file systems (overlay) */
+    if (!p->bi || !file || file->close != _file_close || offset < 0 || size <= 0) {
+        return;
+    }
+
+    block = (uint32_t)(offset / UDF_BLOCK_SIZE);
+    end   = (uint32_t)((offset + size + UDF_BLOCK_SIZE - 1) / UDF_BLOCK_SIZE);
+
+    /* file may be fragmented: hint each contiguous extent separately */
+    while (block < end) {
+        lba = udfread_file_lba(((UDF_FILE*)file->internal)->fp, block);
+        if (!lba) {
+            break;
+        }
+        for (nblocks = 1; block + nblocks < end; nblocks++) {
+            if (udfread_file_lba(((UDF_FILE*)file->internal)->fp, block + nblocks) != lba + nblocks) {
+                break;
+            }
+        }
+        _bi_prefetch(p->bi, lba, nblocks);
+        block += nblocks;
+    }
+}
+
 /*
  * directory access
  */
@@ -121,8 +228,9 @@ static int _dir_read(BD_DIR_H *dir, BD_DIRENT *entry)
     return 0;
 }
 
-BD_DIR_H *udf_dir_open(void *udf, const char* dirname)
+BD_DIR_H *udf_dir_open(void *fs, const char* dirname)
 {
+    UDF_FS  *p = (UDF_FS *)fs;
     BD_DIR_H *dir = calloc(1, sizeof(BD_DIR_H));
     if (!dir) {
         return NULL;
@@ -133,7 +241,9 @@ BD_DIR_H *udf_dir_open(void *udf, const char* dirname)
     dir->close = _dir_close;
     dir->read  = _dir_read;
 
-    dir->internal = udfread_opendir((udfread*)udf, dirname);
+    bd_mutex_lock(&p->mutex);
+    dir->internal = udfread_opendir(p->udf, dirname);
+    bd_mutex_unlock(&p->mutex);
     if (!dir->internal) {
         BD_DEBUG(DBG_DIR, "Error opening %s\n", dirname);
         X_FREE(dir);
@@ -177,22 +287,33 @@ static int _bi_read(struct udfread_block_input *bi_gen, uint32_t lba, void *buf,
     UDF_BI *bi = (UDF_BI *)bi_gen;
     int got = -1;
     int64_t pos = (int64_t)lba * UDF_BLOCK_SIZE;
+    int64_t bytes;
 
-    /* seek + read must be atomic */
-    bd_mutex_lock(&bi->mutex);
-
-    if (file_seek(bi->fp, SEEK_SET, pos) == pos) {
-        int64_t bytes = file_read(bi->fp, (uint8_t*)buf, (int64_t)nblocks * UDF_BLOCK_SIZE);
-        if (bytes > 0) {
-            got = bytes / UDF_BLOCK_SIZE;
-        }
+    if (file_can_pread(bi->fp)) {
+        /* no shared file position */
+        bytes = file_pread(bi->fp, (uint8_t*)buf, (size_t)nblocks * UDF_BLOCK_SIZE, pos);
+    } else {
+        /* seek + read must be atomic */
+        bd_mutex_lock(&bi->mutex);
+        bytes = file_pread(bi->fp, (uint8_t*)buf, (size_t)nblocks * UDF_BLOCK_SIZE, pos);
+        bd_mutex_unlock(&bi->mutex);
     }
 
-    bd_mutex_unlock(&bi->mutex);
+    if (bytes > 0) {
+        got = bytes / UDF_BLOCK_SIZE;
+    }
 
     return got;
 }
 
+static int _bi_prefetch(struct udfread_block_input *bi_gen, uint32_t lba, uint32_t nblocks)
+{
+    UDF_BI *bi = (UDF_BI *)bi_gen;
+
+    file_prefetch(bi->fp, (int64_t)lba * UDF_BLOCK_SIZE, (int64_t)nblocks * UDF_BLOCK_SIZE);
+    return 0;
+}
+
 static struct udfread_block_input *_block_input(const char *img)
 {
     BD_FILE_H *fp = file_open(img, "rb");
@@ -246,10 +367,133 @@ static struct udfread_block_input *_stream_input(void *read_block_handle,
 }
 
 
+/*
+ * sector cache
+ */
+
+#define UDF_CACHE_DEFAULT_SIZE  4096   /* kB */
+
+struct udf_ci_s {
+    struct udfread_block_input  i;
+    struct udfread_block_input *input;  /* uncached input */
+    UDF_CACHE                  *cache;
+    int                         pin;    /* pin all sectors (volume is being opened) */
+};
+
+static int _ci_close(struct udfread_block_input *bi_gen)
+{
+    UDF_CI *ci = (UDF_CI *)bi_gen;
+    int result = ci->input->close(ci->input);
+    udf_cache_free(&ci->cache);
+    X_FREE(ci);
+    return result;
+}
+
+static uint32_t _ci_size(struct udfread_block_input *bi_gen)
+{
+    UDF_CI *ci = (UDF_CI *)bi_gen;
+    return ci->input->size(ci->input);
+}
+
+static int _ci_read(struct udfread_block_input *bi_gen, uint32_t lba, void *buf, uint32_t nblocks, int flags)
+{
+    UDF_CI  *ci = (UDF_CI *)bi_gen;
+    uint8_t *p  = (uint8_t *)buf;
+    uint32_t first, last, ii;
+    int      got;
+
+    /* cache metadata only */
+    if (flags & UDF_READ_NOCACHE) {
+        return ci->input->read(ci->input, lba, buf, nblocks, flags & ~UDF_READ_NOCACHE);
+    }
+
+    /* read only the range between cached sectors */
+    for (first = 0; first < nblocks; first++) {
+        if (!udf_cache_get(ci->cache, lba + first, p + first * UDF_BLOCK_SIZE)) {
+            break;
+        }
+    }
+    if (first == nblocks) {
+        return (int)nblocks;
+    }
+    for (last = nblocks; last > first + 1; last--) {
+        if (!udf_cache_get(ci->cache, lba + last - 1, p + (last - 1) * UDF_BLOCK_SIZE)) {
+            break;
+        }
+    }
+
+    got = ci->input->read(ci->input, lba + first, p + first * UDF_BLOCK_SIZE, last - first, flags);
+    if (got <= 0) {
+        return first ? (int)first : got;
+    }
+
+    for (ii = 0; ii < (uint32_t)got; ii++) {
+        udf_cache_put(ci->cache, lba + first + ii, p + (first + ii) * UDF_BLOCK_SIZE, ci->pin);
+    }
+
+    if ((uint32_t)got < last - first) {
+        return (int)first + got;
+    }
+    return (int)nblocks;
+}
+
+static UDF_CI *_cache_input(struct udfread_block_input *input)
+{
+    const char *env = getenv("LIBBLURAY_UDF_CACHE_SIZE");
+    long        kb  = env ? strtol(env, NULL, 10) : UDF_CACHE_DEFAULT_SIZE;
+    UDF_CI     *ci;
+
+    if (kb <= 0) {
+        return NULL;
+    }
+
+    ci = calloc(1, sizeof(*ci));
+    if (!ci) {
+        return NULL;
+    }
+
+    ci->cache = udf_cache_init((unsigned)BD_MIN(kb, 1024 * 1024) * 1024 / UDF_BLOCK_SIZE);
+    if (!ci->cache) {
+        X_FREE(ci);
+        return NULL;
+    }
+
+    ci->input  = input;
+    ci->i.close = _ci_close;
+    ci->i.read  = _ci_read;
+    ci->i.size  = input->size ? _ci_size : NULL;
+    return ci;
+}
+
+static int _open_input(UDF_FS *fs, udfread *udf, struct udfread_block_input *input)
+{
+    UDF_CI *ci = _cache_input(input);
+    int     result;
+
+    if (!ci) {
+        return udfread_open_input(udf, input);
+    }
+
+    /* volume structures, file set and root directory are needed for every lookup */
+    ci->pin = 1;
+    result = udfread_open_input(udf, &ci->i);
+    ci->pin = 0;
+
+    if (result < 0) {
+        /* caller closes the uncached input */
+        udf_cache_free(&ci->cache);
+        X_FREE(ci);
+    } else {
+        fs->ci = ci;
+    }
+    return result;
+}
+
 void *udf_image_open(const char *img_path,
                      void *read_block_handle,
                      int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks))
 {
+    UDF_FS  *fs;
     udfread *udf = udfread_init();
     int result = -1;
 
@@ -257,24 +501,32 @@ void *udf_image_open(const char *img_path,
         return NULL;
     }
 
+    fs = calloc(1, sizeof(*fs));
+    if (!fs) {
+        udfread_close(udf);
+        return NULL;
+    }
+
     /* stream ? */
     if (read_blocks) {
         struct udfread_block_input *si = _stream_input(read_block_handle, read_blocks);
         if (si) {
-            result = udfread_open_input(udf, si);
+            result = _open_input(fs, udf, si);
             if (result < 0) {
                 si->close(si);
             }
         }
     } else {
 
-        /* app handles file I/O ? */
-        if (result < 0 && file_open != file_open_default()) {
+        /* use our block input: it handles application file I/O and prefetch hints */
+        if (result < 0) {
             struct udfread_block_input *bi = _block_input(img_path);
             if (bi) {
-                result = udfread_open_input(udf, bi);
+                result = _open_input(fs, udf, bi);
                 if (result < 0) {
                     bi->close(bi);
+                } else {
+                    fs->bi = bi;
                 }
             }
         }
@@ -286,18 +538,26 @@ void *udf_image_open(const char *img_path,
 
     if (result < 0) {
         udfread_close(udf);
+        X_FREE(fs);
         return NULL;
     }
 
-    return (void*)udf;
+    fs->udf = udf;
+    bd_mutex_init(&fs->mutex);
+    return (void*)fs;
 }
 
-const char *udf_volume_id(void *udf)
+const char *udf_volume_id(void *fs)
 {
-    return udfread_get_volume_id((udfread*)udf);
+    return udfread_get_volume_id(((UDF_FS *)fs)->udf);
 }
 
-void udf_image_close(void *udf)
+void udf_image_close(void *fs)
 {
-    udfread_close((udfread*)udf);
+    if (fs) {
+        /* block input is closed by libudfread */
+        udfread_close(((UDF_FS *)fs)->udf);
+        bd_mutex_destroy(&((UDF_FS *)fs)->mutex);
+        X_FREE(fs);
+    }
 }
@@ -22,6 +22,8 @@
 
 #include "util/attributes.h"
 
+#include <stdint.h>
+
 struct bd_file_s;
 struct bd_dir_s;
 
@@ -34,4 +36,7 @@ BD_PRIVATE const char       *udf_volume_id(void *udf);
 BD_PRIVATE struct bd_file_s *udf_file_open(void *udf, const char *filename);
 BD_PRIVATE struct bd_dir_s  *udf_dir_open(void *udf, const char* dirname);
 
+/* Hint: file range will be read soon */
+BD_PRIVATE void              udf_file_prefetch(void *udf, struct bd_file_s *file, int64_t offset, int64_t size);
+
 #endif /* _BD_UDF_FS_H_ */
@@ -33,6 +33,7 @@
 #include "util/logging.h"
 #include "util/macro.h"
 #include "util/strutl.h"
+#include "util/trace.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -223,13 +224,14 @@ static MOBJ_OBJECTS *_mobj_get(BD_DISC *disc, const char *path)
 MOBJ_OBJECTS *mobj_get(BD_DISC *disc)
 {
     MOBJ_OBJECTS *objects;
+    int64_t       trace = bd_trace_begin();
 
     objects = _mobj_get(disc, "BDMV" DIR_SEP "MovieObject.bdmv");
-    if (objects) {
-        return objects;
+    if (!objects) {
+        /* if failed, try backup file */
+        objects = _mobj_get(disc, "BDMV" DIR_SEP "BACKUP" DIR_SEP "MovieObject.bdmv");
     }
 
-    /* if failed, try backup file */
-    objects = _mobj_get(disc, "BDMV" DIR_SEP "BACKUP" DIR_SEP "MovieObject.bdmv");
+    bd_trace_end(trace, "mobj_get", NULL);
     return objects;
 }
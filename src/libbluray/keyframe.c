@@ -0,0 +1,339 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "keyframe.h"
+
+#include "bluray.h"
+#include "bdnav/clpi_data.h"
+#include "bdnav/clpi_parse.h"
+#include "bdnav/navigation.h"
+#include "decoders/hdmv_pids.h"
+#include "disc/disc.h"
+#include "file/file.h"
+#include "util/logging.h"
+#include "util/macro.h"
+#include "util/mutex.h"
+#include "util/thread.h"
+
+#include <inttypes.h>
+#include <stdio.h> // SEEK_
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_WORKERS  4
+
+/* Stream Packet Number = byte offset / 192 */
+#define SPN(pos) ((uint32_t)((pos) / 192))
+
+typedef struct {
+    const NAV_CLIP *clip;    /* NULL if not found */
+    uint32_t        pkt;     /* first packet of I-picture */
+    uint32_t        end_pkt; /* end of I-picture */
+} KF_LOCATION;
+
+typedef struct {
+    BD_DISC         *disc;
+    BLURAY_KEYFRAME *frames;
+    KF_LOCATION     *loc;
+    unsigned         count;
+
+    const NAV_CLIP **clips;  /* clips to process */
+    unsigned         num_clips;
+
+    BD_MUTEX         mutex;
+    unsigned         next_clip;
+    int              threaded;  /* mutex is initialized and workers are running */
+} KF_CONTEXT;
+
+/*
+ * locate EP map entry
+ */
+
+static int _locate(const NAV_TITLE *title, BLURAY_KEYFRAME *frame, KF_LOCATION *loc)
+{
+    const NAV_CLIP *clip;
+    uint32_t tick, clip_tick, clip_pkt, out_pkt, time, next_time;
+    int ep;
+
+    if (frame->request >> 33 || frame->request / 2 >= title->duration) {
+        return 0;
+    }
+    tick = (uint32_t)(frame->request / 2);
+
+    clip = nav_time_search(title, tick, &clip_pkt, &out_pkt);
+    if (!clip || !clip->cl || clpi_ep_count(clip->cl) < 1) {
+        return 0;
+    }
+
+    clip_tick = tick - clip->title_time + clip->in_time;
+
+    ep = clpi_ep_find(clip->cl, clip_pkt);
+    if (ep < 0) {
+        ep = 0;
+    }
+    loc->pkt = clpi_ep_entry(clip->cl, ep, &loc->end_pkt, &time);
+
+    /* use following entry if it is closer */
+    if (ep + 1 < clpi_ep_count(clip->cl)) {
+        uint32_t next_end, next_pkt = clpi_ep_entry(clip->cl, ep + 1, &next_end, &next_time);
+        if (next_pkt < clip->end_pkt && next_time > clip_tick && time <= clip_tick &&
+            next_time - clip_tick < clip_tick - time) {
+            loc->pkt     = next_pkt;
+            loc->end_pkt = next_end;
+            time         = next_time;
+        }
+    }
+
+    if (loc->pkt >= clip->end_pkt) {
+        return 0;
+    }
+    if (loc->end_pkt > clip->end_pkt) {
+        loc->end_pkt = clip->end_pkt;
+    }
+
+    loc->clip = clip;
+
+    frame->clip_ref = clip->ref;
+    memcpy(frame->clip_id, clip->name, 5);
+    frame->clip_id[5] = 0;
+    frame->pts = 0;
+    if (time >= clip->in_time) {
+        frame->pts = (uint64_t)(time - clip->in_time + clip->title_time) * 2;
+    }
+
+    return 1;
+}
+
+/*
+ * read key frame
+ */
+
+static int _read_unit(BD_FILE_H *fp, uint8_t *buf)
+{
+    return file_read(fp, buf, 6144) == 6144;
+}
+
+static void _load_frame(BD_FILE_H *fp, uint16_t video_pid,
+                        const uint8_t *psi, size_t psi_len,
+                        BLURAY_KEYFRAME *frame, const KF_LOCATION *loc)
+{
+    uint8_t  unit[6144];
+    uint64_t pos = ((uint64_t)loc->pkt * 192 / 6144) * 6144;
+    uint64_t end = (((uint64_t)loc->end_pkt * 192 + 6143) / 6144) * 6144;
+    unsigned ii;
+
+    frame->start = pos;
+    frame->end   = end;
+
+    frame->data = malloc(psi_len + (size_t)(end - pos));
+    if (!frame->data) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "out of memory\n");
+        return;
+    }
+
+    memcpy(frame->data, psi, psi_len);
+    frame->size = (uint32_t)psi_len;
+
+    if (file_seek(fp, pos, SEEK_SET) < 0) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to seek clip %s!\n", frame->clip_id);
+        return;
+    }
+
+    for (; pos < end; pos += 6144) {
+        if (!_read_unit(fp, unit)) {
+            BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Read from clip %s failed at %" PRIu64 "\n", frame->clip_id, pos);
+            break;
+        }
+
+        for (ii = 0; ii < 6144; ii += 192) {
+            const uint8_t *pkt = unit + ii;
+            uint32_t spn = SPN(pos + ii);
+            uint16_t pid;
+
+            if (spn >= loc->end_pkt) {
+                break;
+            }
+            if (pkt[4] != 0x47) {
+                /* broken or encrypted packet */
+                continue;
+            }
+
+            /* PAT/PMT/PCR preceding the I-picture and video packets */
+            pid = TS_PID(pkt);
+            if (pid <= HDMV_PID_PCR || (pid == video_pid && spn >= loc->pkt)) {
+                memcpy(frame->data + frame->size, pkt, 192);
+                frame->size += 192;
+            }
+        }
+    }
+}
+
+/* Opening and closing streams touches shared disc state
+ * (UDF file system, AACS title selection): serialize it */
+
+static BD_FILE_H *_open_stream(KF_CONTEXT *ctx, const NAV_CLIP *clip)
+{
+    BD_FILE_H *fp;
+
+    if (ctx->threaded) {
+        bd_mutex_lock(&ctx->mutex);
+    }
+    fp = disc_open_stream(ctx->disc, clip->name);
+    if (ctx->threaded) {
+        bd_mutex_unlock(&ctx->mutex);
+    }
+
+    return fp;
+}
+
+static void _close_stream(KF_CONTEXT *ctx, const NAV_CLIP *clip, BD_FILE_H *fp)
+{
+    if (ctx->threaded) {
+        bd_mutex_lock(&ctx->mutex);
+    }
+    disc_close_stream(ctx->disc, clip->name, fp);
+    if (ctx->threaded) {
+        bd_mutex_unlock(&ctx->mutex);
+    }
+}
+
+static void _process_clip(KF_CONTEXT *ctx, const NAV_CLIP *clip)
+{
+    BD_FILE_H *fp;
+    uint8_t    unit[6144];
+    uint8_t    psi[6144];
+    size_t     psi_len = 0;
+    unsigned   ii;
+
+    fp = _open_stream(ctx, clip);
+    if (!fp) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to open clip %s!\n", clip->name);
+        return;
+    }
+
+    /* PAT and PMT are at the start of each clip */
+    if (_read_unit(fp, unit)) {
+        for (ii = 0; ii < 6144; ii += 192) {
+            if (unit[ii + 4] == 0x47 && TS_PID(unit + ii) < HDMV_PID_PCR) {
+                memcpy(psi + psi_len, unit + ii, 192);
+                psi_len += 192;
+            }
+        }
+    }
+
+    for (ii = 0; ii < ctx->count; ii++) {
+        if (ctx->loc[ii].clip == clip) {
+            _load_frame(fp, clip->cl->cpi.entry[0].pid, psi, psi_len, &ctx->frames[ii], &ctx->loc[ii]);
+        }
+    }
+
+    _close_stream(ctx, clip, fp);
+}
+
+static void _worker(void *p)
+{
+    KF_CONTEXT *ctx = (KF_CONTEXT *)p;
+
+    while (1) {
+        unsigned idx;
+
+        bd_mutex_lock(&ctx->mutex);
+        idx = ctx->next_clip++;
+        bd_mutex_unlock(&ctx->mutex);
+
+        if (idx >= ctx->num_clips) {
+            break;
+        }
+
+        _process_clip(ctx, ctx->clips[idx]);
+    }
+}
+
+/*
+ *
+ */
+
+unsigned keyframe_extract(BD_DISC *disc, const NAV_TITLE *title,
+                          BLURAY_KEYFRAME *frames, unsigned count)
+{
+    KF_CONTEXT ctx;
+    BD_THREAD  threads[MAX_WORKERS];
+    unsigned   num_threads = 0;
+    unsigned   found = 0;
+    unsigned   ii, jj;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.disc   = disc;
+    ctx.frames = frames;
+    ctx.count  = count;
+    ctx.loc    = calloc(count, sizeof(*ctx.loc));
+    ctx.clips  = calloc(count, sizeof(*ctx.clips));
+    if (!ctx.loc || !ctx.clips) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "out of memory\n");
+        goto out;
+    }
+
+    /* locate key frames and collect clips */
+    for (ii = 0; ii < count; ii++) {
+        if (!_locate(title, &frames[ii], &ctx.loc[ii])) {
+            BD_DEBUG(DBG_BLURAY, "No key frame for timestamp %" PRIu64 "\n", frames[ii].request);
+            continue;
+        }
+        found++;
+        for (jj = 0; jj < ctx.num_clips && ctx.clips[jj] != ctx.loc[ii].clip; jj++) ;
+        if (jj == ctx.num_clips) {
+            ctx.clips[ctx.num_clips++] = ctx.loc[ii].clip;
+        }
+    }
+
+    /* clips are independent: load them in parallel */
+    if (ctx.num_clips > 1 && bd_mutex_init(&ctx.mutex) == 0) {
+        ctx.threaded = 1;
+        while (num_threads < MAX_WORKERS && num_threads + 1 < ctx.num_clips) {
+            if (bd_thread_create(&threads[num_threads], _worker, &ctx) < 0) {
+                break;
+            }
+            num_threads++;
+        }
+
+        _worker(&ctx);
+
+        for (ii = 0; ii < num_threads; ii++) {
+            bd_thread_join(&threads[ii]);
+        }
+        bd_mutex_destroy(&ctx.mutex);
+
+    } else {
+        for (ii = 0; ii < ctx.num_clips; ii++) {
+            _process_clip(&ctx, ctx.clips[ii]);
+        }
+    }
+
+    BD_DEBUG(DBG_BLURAY, "Loaded %u key frames from %u clips (%u threads)\n",
+             found, ctx.num_clips, num_threads + 1);
+
+ out:
+    X_FREE(ctx.loc);
+    X_FREE(ctx.clips);
+    return found;
+}
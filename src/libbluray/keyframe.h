@@ -0,0 +1,37 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined(_BD_KEYFRAME_H_)
+#define _BD_KEYFRAME_H_
+
+#include "util/attributes.h"
+
+struct bd_disc;
+struct nav_title_s;
+struct bd_keyframe;
+
+/*
+ * Locate and load key frames (I-pictures) nearest to frames[].request.
+ * Returns number of key frames found.
+ */
+
+BD_PRIVATE unsigned keyframe_extract(struct bd_disc *disc, const struct nav_title_s *title,
+                                     struct bd_keyframe *frames, unsigned count);
+
+#endif /* _BD_KEYFRAME_H_ */
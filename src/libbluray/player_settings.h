@@ -192,4 +192,23 @@ enum {
     BLURAY_PERSISTENT_STORAGE_ENABLE  = 1,  /**< enable persistent storage */
 };
 
+
+/**
+ * BLURAY_PLAYER_SETTING_OVERLAY_PALETTE
+ *
+ * Convert YUV overlay palettes to ARGB (BD_OVERLAY palette_argb).
+ *
+ * Value is color matrix, optionally combined with BLURAY_PALETTE_PREMULTIPLIED.
+ * Palette is converted once for each palette change.
+ */
+
+enum {
+    BLURAY_PALETTE_NONE          = 0,     /**< no ARGB palette (default) */
+    BLURAY_PALETTE_BT601         = 1,     /**< ITU-R BT.601 color matrix */
+    BLURAY_PALETTE_BT709         = 2,     /**< ITU-R BT.709 color matrix */
+    BLURAY_PALETTE_BT2020        = 3,     /**< ITU-R BT.2020 color matrix */
+
+    BLURAY_PALETTE_PREMULTIPLIED = 0x10,  /**< flag: color components are premultiplied with alpha */
+};
+
 #endif /* BD_PLAYER_SETTINGS_H_ */
@@ -91,6 +91,21 @@ void bd_set_debug_mask(uint32_t mask);
  */
 uint32_t bd_get_debug_mask(void);
 
+/**
+ * Write (global) timeline trace
+ *
+ * Timing of disc open, title listing, playlist open and BD-J startup
+ * is written to file in Chrome trace event format (JSON).
+ * Trace can be viewed with chrome://tracing or Perfetto.
+ *
+ * Tracing can be enabled also with environment variable BD_TRACE_FILE.
+ * This function should be called before any disc is opened.
+ *
+ * @param file  trace file path, NULL to stop tracing
+ * @return 0 on success, -1 on error
+ */
+int bd_set_trace_file(const char *file);
+
 #ifdef __cplusplus
 }
 #endif
@@ -65,6 +65,115 @@ static int _mutex_destroy(MUTEX_IMPL *p)
     return 0;
 }
 
+/* CONDITION_VARIABLE requires Vista.
+ * Broadcast with one manual-reset event per generation: broadcast signals the
+ * event of current waiters and starts a new generation. Threads arriving later
+ * wait on the new (non-signaled) event. Last waiter of a generation frees it. */
+typedef struct {
+    HANDLE   event;
+    unsigned waiters;
+} COND_GEN;
+
+typedef struct {
+    CRITICAL_SECTION lock;
+    COND_GEN        *gen;   /* current generation */
+} COND_IMPL;
+
+static COND_GEN *_cond_gen_new(void)
+{
+    COND_GEN *g = calloc(1, sizeof(*g));
+    if (g) {
+        g->event = CreateEvent(NULL, TRUE, FALSE, NULL);
+        if (!g->event) {
+            BD_DEBUG(DBG_BLURAY|DBG_CRIT, "CreateEvent() failed !\n");
+            X_FREE(g);
+        }
+    }
+    return g;
+}
+
+static void _cond_gen_free(COND_GEN *g)
+{
+    CloseHandle(g->event);
+    free(g);
+}
+
+static int _cond_init(COND_IMPL *p)
+{
+    p->gen = _cond_gen_new();
+    if (!p->gen) {
+        return -1;
+    }
+    InitializeCriticalSection(&p->lock);
+    return 0;
+}
+
+static int _cond_destroy(COND_IMPL *p)
+{
+    DeleteCriticalSection(&p->lock);
+    _cond_gen_free(p->gen);
+    return 0;
+}
+
+static int _cond_wait(COND_IMPL *p, MUTEX_IMPL *m)
+{
+    COND_GEN *g;
+
+    EnterCriticalSection(&p->lock);
+    g = p->gen;
+    g->waiters++;
+    LeaveCriticalSection(&p->lock);
+
+    LeaveCriticalSection(&m->cs);
+
+    WaitForSingleObject(g->event, INFINITE);
+
+    EnterCriticalSection(&p->lock);
+    if (--g->waiters == 0 && g != p->gen) {
+        _cond_gen_free(g);
+    }
+    LeaveCriticalSection(&p->lock);
+
+    EnterCriticalSection(&m->cs);
+    return 0;
+}
+
+static int _cond_broadcast(COND_IMPL *p)
+{
+    EnterCriticalSection(&p->lock);
+    if (p->gen->waiters > 0) {
+        COND_GEN *next = _cond_gen_new();
+        SetEvent(p->gen->event);
+        /* if allocation failed, keep generation: later waiters wake up spuriously */
+        if (next) {
+            p->gen = next;
+        }
+    }
+    LeaveCriticalSection(&p->lock);
+    return 0;
+}
+
+/* critical section can't be initialized statically */
+static CRITICAL_SECTION global_cs;
+static volatile LONG    global_cs_state; /* 0 - not initialized, 1 - initializing, 2 - ready */
+
+void bd_global_lock(void)
+{
+    if (InterlockedCompareExchange(&global_cs_state, 1, 0) == 0) {
+        InitializeCriticalSection(&global_cs);
+        InterlockedExchange(&global_cs_state, 2);
+    }
+    while (global_cs_state != 2) {
+        Sleep(0);
+    }
+    EnterCriticalSection(&global_cs);
+}
+
+void bd_global_unlock(void)
+{
+    LeaveCriticalSection(&global_cs);
+}
+
 
 #elif defined(HAVE_PTHREAD_H)
 
@@ -115,6 +224,64 @@ static int _mutex_destroy(MUTEX_IMPL *p)
     return 0;
 }
 
+typedef pthread_cond_t COND_IMPL;
+
+static int _cond_init(COND_IMPL *p)
+{
+    if (pthread_cond_init(p, NULL)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_cond_init() failed !\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int _cond_destroy(COND_IMPL *p)
+{
+    if (pthread_cond_destroy(p)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_cond_destroy() failed !\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int _cond_wait(COND_IMPL *p, MUTEX_IMPL *m)
+{
+    if (pthread_cond_wait(p, m)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_cond_wait() failed !\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int _cond_broadcast(COND_IMPL *p)
+{
+    if (pthread_cond_broadcast(p)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_cond_broadcast() failed !\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static pthread_mutex_t global_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void bd_global_lock(void)
+{
+    if (pthread_mutex_lock(&global_mutex)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_mutex_lock() failed !\n");
+    }
+}
+
+void bd_global_unlock(void)
+{
+    if (pthread_mutex_unlock(&global_mutex)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_mutex_unlock() failed !\n");
+    }
+}
+
 #endif /* HAVE_PTHREAD_H */
 
 int bd_mutex_lock(BD_MUTEX *p)
@@ -135,6 +302,60 @@ int bd_mutex_unlock(BD_MUTEX *p)
     return _mutex_unlock((MUTEX_IMPL*)p->impl);
 }
 
+static void *_mutex_create(void)
+{
+    MUTEX_IMPL *impl = calloc(1, sizeof(MUTEX_IMPL));
+    if (impl && _mutex_init(impl) < 0) {
+        X_FREE(impl);
+    }
+    return impl;
+}
+
+/* publish impl if p->impl is still NULL. Return current impl. */
+static void *_mutex_publish(BD_MUTEX *p, void *impl)
+{
+#if defined(_WIN32)
+    void *old = InterlockedCompareExchangePointer((PVOID volatile *)&p->impl, impl, NULL);
+#elif defined(__GNUC__)
+    void *old = __sync_val_compare_and_swap(&p->impl, NULL, impl);
+#else
+    static pthread_mutex_t publish_mutex = PTHREAD_MUTEX_INITIALIZER;
+    void *old;
+    pthread_mutex_lock(&publish_mutex);
+    old = p->impl;
+    if (!old) {
+        p->impl = impl;
+    }
+    pthread_mutex_unlock(&publish_mutex);
+#endif
+    if (old) {
+        /* lost the race */
+        _mutex_destroy((MUTEX_IMPL*)impl);
+        X_FREE(impl);
+        return old;
+    }
+    return impl;
+}
+
+int bd_mutex_lock_static(BD_MUTEX *p)
+{
+#if defined(__GNUC__) && !defined(_WIN32)
+    void *impl = __atomic_load_n(&p->impl, __ATOMIC_ACQUIRE);
+#else
+    void *impl = *(void * volatile *)&p->impl;
+#endif
+
+    if (!impl) {
+        impl = _mutex_create();
+        if (!impl) {
+            BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_mutex_lock_static() failed !\n");
+            return -1;
+        }
+        impl = _mutex_publish(p, impl);
+    }
+    return _mutex_lock((MUTEX_IMPL*)impl);
+}
+
 int bd_mutex_init(BD_MUTEX *p)
 {
     p->impl = calloc(1, sizeof(MUTEX_IMPL));
@@ -165,3 +386,52 @@ int bd_mutex_destroy(BD_MUTEX *p)
     X_FREE(p->impl);
     return 0;
 }
+
+int bd_cond_init(BD_COND *p)
+{
+    p->impl = calloc(1, sizeof(COND_IMPL));
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_cond_init() failed !\n");
+        return -1;
+    }
+
+    if (_cond_init((COND_IMPL*)p->impl) < 0) {
+        X_FREE(p->impl);
+        return -1;
+    }
+
+    return 0;
+}
+
+int bd_cond_destroy(BD_COND *p)
+{
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_cond_destroy() failed !\n");
+        return -1;
+    }
+
+    if (_cond_destroy((COND_IMPL*)p->impl) < 0) {
+        return -1;
+    }
+
+    X_FREE(p->impl);
+    return 0;
+}
+
+int bd_cond_wait(BD_COND *p, BD_MUTEX *m)
+{
+    if (!p->impl || !m->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_cond_wait() failed !\n");
+        return -1;
+    }
+    return _cond_wait((COND_IMPL*)p->impl, (MUTEX_IMPL*)m->impl);
+}
+
+int bd_cond_broadcast(BD_COND *p)
+{
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_cond_broadcast() failed !\n");
+        return -1;
+    }
+    return _cond_broadcast((COND_IMPL*)p->impl);
+}
@@ -37,4 +37,31 @@ BD_PRIVATE int bd_mutex_destroy(BD_MUTEX *p);
 BD_PRIVATE int bd_mutex_lock(BD_MUTEX *p);
 BD_PRIVATE int bd_mutex_unlock(BD_MUTEX *p);
 
+/* lock mutex in static storage (zero-initialized, no bd_mutex_init() required).
+ * Mutex is initialized on first use and never destroyed. Unlock with bd_mutex_unlock(). */
+BD_PRIVATE int bd_mutex_lock_static(BD_MUTEX *p);
+
+/*
+ * condition variable
+ */
+
+typedef struct bd_cond_s BD_COND;
+struct bd_cond_s {
+    void *impl;
+};
+
+BD_PRIVATE int bd_cond_init(BD_COND *p);
+BD_PRIVATE int bd_cond_destroy(BD_COND *p);
+
+/* mutex must be locked (once) by the calling thread. Wakeups may be spurious. */
+BD_PRIVATE int bd_cond_wait(BD_COND *p, BD_MUTEX *m);
+BD_PRIVATE int bd_cond_broadcast(BD_COND *p);
+
+/*
+ * process-wide lock (statically allocated, no initialization required)
+ */
+
+BD_PRIVATE void bd_global_lock(void);
+BD_PRIVATE void bd_global_unlock(void);
+
 #endif // LIBBLURAY_MUTEX_H_
@@ -0,0 +1,140 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "thread.h"
+
+#include "logging.h"
+#include "macro.h"
+
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#elif defined(HAVE_PTHREAD_H)
+#   include <pthread.h>
+#else
+#   error no thread support found
+#endif
+
+typedef struct {
+    void  (*func)(void *);
+    void   *arg;
+#if defined(_WIN32)
+    HANDLE  handle;
+#else
+    pthread_t thread;
+#endif
+} THREAD_IMPL;
+
+#if defined(_WIN32)
+
+static DWORD WINAPI _thread_entry(LPVOID p)
+{
+    THREAD_IMPL *impl = (THREAD_IMPL *)p;
+    impl->func(impl->arg);
+    return 0;
+}
+
+static int _thread_create(THREAD_IMPL *p)
+{
+    p->handle = CreateThread(NULL, 0, _thread_entry, p, 0, NULL);
+    if (!p->handle) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "CreateThread() failed !\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int _thread_join(THREAD_IMPL *p)
+{
+    WaitForSingleObject(p->handle, INFINITE);
+    CloseHandle(p->handle);
+    return 0;
+}
+
+#elif defined(HAVE_PTHREAD_H)
+
+static void *_thread_entry(void *p)
+{
+    THREAD_IMPL *impl = (THREAD_IMPL *)p;
+    impl->func(impl->arg);
+    return NULL;
+}
+
+static int _thread_create(THREAD_IMPL *p)
+{
+    if (pthread_create(&p->thread, NULL, _thread_entry, p)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_create() failed !\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int _thread_join(THREAD_IMPL *p)
+{
+    if (pthread_join(p->thread, NULL)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_join() failed !\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+#endif /* HAVE_PTHREAD_H */
+
+int bd_thread_create(BD_THREAD *p, void (*func)(void *), void *arg)
+{
+    THREAD_IMPL *impl = calloc(1, sizeof(THREAD_IMPL));
+    if (!impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_thread_create() failed !\n");
+        return -1;
+    }
+
+    impl->func = func;
+    impl->arg  = arg;
+
+    if (_thread_create(impl) < 0) {
+        X_FREE(impl);
+        return -1;
+    }
+
+    p->impl = impl;
+    return 0;
+}
+
+int bd_thread_join(BD_THREAD *p)
+{
+    int result;
+
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_thread_join() failed !\n");
+        return -1;
+    }
+
+    result = _thread_join((THREAD_IMPL*)p->impl);
+
+    X_FREE(p->impl);
+    return result;
+}
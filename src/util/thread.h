@@ -0,0 +1,37 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBBLURAY_THREAD_H_
+#define LIBBLURAY_THREAD_H_
+
+#include "attributes.h"
+
+/*
+ * joinable thread
+ */
+
+typedef struct bd_thread_s BD_THREAD;
+struct bd_thread_s {
+    void *impl;
+};
+
+BD_PRIVATE int bd_thread_create(BD_THREAD *p, void (*func)(void *), void *arg);
+BD_PRIVATE int bd_thread_join(BD_THREAD *p);
+
+#endif // LIBBLURAY_THREAD_H_
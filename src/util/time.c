@@ -35,7 +35,7 @@
 
 #if defined(_WIN32)
 
-static uint64_t _bd_get_scr_impl(void)
+static uint64_t _bd_get_time_us_impl(void)
 {
     HANDLE thread;
     DWORD_PTR mask;
@@ -47,20 +47,38 @@ static uint64_t _bd_get_scr_impl(void)
     QueryPerformanceCounter(&counter);
     SetThreadAffinityMask(thread, mask);
 
-    return (uint64_t)(counter.QuadPart * 1000.0 / frequency.QuadPart) * 90;
+    return (uint64_t)(counter.QuadPart * 1000000.0 / frequency.QuadPart);
 }
 
 #elif defined(HAVE_SYS_TIME_H)
 
-static uint64_t _bd_get_scr_impl(void)
+static uint64_t _bd_get_time_us_impl(void)
 {
     struct timeval tv;
     gettimeofday(&tv, 0);
-    return ((uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000) * 90;
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
 }
 
 #endif
 
+static uint64_t _bd_get_scr_impl(void)
+{
+    return _bd_get_time_us_impl() / 1000 * 90;
+}
+
+uint64_t bd_get_time_us(void)
+{
+    static uint64_t t0 = (uint64_t)-1;
+
+    uint64_t now = _bd_get_time_us_impl();
+
+    if (t0 > now) {
+        t0 = now;
+    }
+
+    return now - t0;
+}
+
 uint64_t bd_get_scr(void)
 {
     static uint64_t t0 = (uint64_t)-1;
@@ -25,5 +25,6 @@
 #include <stdint.h>
 
 BD_PRIVATE uint64_t bd_get_scr(void);
+BD_PRIVATE uint64_t bd_get_time_us(void);  /* microseconds */
 
 #endif // LIBBLURAY_TIME_H_
@@ -0,0 +1,168 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "trace.h"
+
+#include "log_control.h"
+#include "logging.h"
+#include "mutex.h"
+#include "time.h"
+
+#include <signal.h>  // sig_atomic_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#elif defined(HAVE_PTHREAD_H)
+#   include <pthread.h>
+#endif
+
+#define TRACE_UNKNOWN  0  /* BD_TRACE_FILE not checked yet */
+#define TRACE_DISABLED 1
+#define TRACE_ENABLED  2
+
+/* read without lock: avoids locking when tracing is disabled */
+static volatile sig_atomic_t trace_state = TRACE_UNKNOWN;
+
+/* protected by trace_mutex */
+static BD_MUTEX trace_mutex;
+static FILE    *trace_file = NULL;
+
+static unsigned long _thread_id(void)
+{
+#if defined(_WIN32)
+    return (unsigned long)GetCurrentThreadId();
+#elif defined(HAVE_PTHREAD_H)
+    return (unsigned long)(uintptr_t)pthread_self();
+#else
+    return 0;
+#endif
+}
+
+static int _open(const char *file)
+{
+    FILE *fp = NULL;
+
+    if (file) {
+        fp = fopen(file, "wb");
+        if (!fp) {
+            BD_DEBUG(DBG_CRIT, "Error opening trace file %s\n", file);
+            return -1;
+        }
+        /* JSON array format. Closing ] is optional. */
+        fputs("[\n", fp);
+        fflush(fp);
+    }
+
+    if (trace_file) {
+        fclose(trace_file);
+    }
+    trace_file = fp;
+    trace_state = fp ? TRACE_ENABLED : TRACE_DISABLED;
+    return 0;
+}
+
+int bd_set_trace_file(const char *file)
+{
+    int result;
+
+    bd_mutex_lock_static(&trace_mutex);
+    result = _open(file);
+    if (result < 0 && trace_state == TRACE_UNKNOWN) {
+        trace_state = TRACE_DISABLED;
+    }
+    bd_mutex_unlock(&trace_mutex);
+
+    return result;
+}
+
+int64_t bd_trace_begin(void)
+{
+    if (trace_state == TRACE_UNKNOWN) {
+        bd_mutex_lock_static(&trace_mutex);
+
+        /* Only call getenv() once. */
+        if (trace_state == TRACE_UNKNOWN) {
+            if (_open(getenv("BD_TRACE_FILE")) < 0) {
+                trace_state = TRACE_DISABLED;
+            }
+        }
+
+        bd_mutex_unlock(&trace_mutex);
+    }
+
+    return trace_state == TRACE_ENABLED ? (int64_t)bd_get_time_us() : -1;
+}
+
+/* copy string, replace characters that would need escaping in JSON */
+static void _json_str(char *dst, size_t size, const char *src)
+{
+    size_t i;
+
+    for (i = 0; src[i] && i < size - 1; i++) {
+        char c = src[i];
+        dst[i] = (c == '"' || c == '\\' || (unsigned char)c < 0x20) ? '_' : c;
+    }
+    dst[i] = 0;
+}
+
+void bd_trace_end(int64_t start, const char *name, const char *detail)
+{
+    FILE    *fp;
+    char     s_name[64], s_detail[256];
+    uint64_t now;
+
+    if (start < 0) {
+        return;
+    }
+
+    now = bd_get_time_us();
+    _json_str(s_name, sizeof(s_name), name);
+    if (detail) {
+        _json_str(s_detail, sizeof(s_detail), detail);
+    }
+
+    /* trace file may be replaced from another thread */
+    bd_mutex_lock_static(&trace_mutex);
+
+    fp = trace_file;
+    if (!fp) {
+        bd_mutex_unlock(&trace_mutex);
+        return;
+    }
+
+    if (detail) {
+        fprintf(fp, "{\"name\":\"%s\",\"cat\":\"libbluray\",\"ph\":\"X\",\"ts\":%" PRId64 ",\"dur\":%" PRIu64
+                ",\"pid\":1,\"tid\":%lu,\"args\":{\"detail\":\"%s\"}},\n",
+                s_name, start, now - (uint64_t)start, _thread_id(), s_detail);
+    } else {
+        fprintf(fp, "{\"name\":\"%s\",\"cat\":\"libbluray\",\"ph\":\"X\",\"ts\":%" PRId64 ",\"dur\":%" PRIu64
+                ",\"pid\":1,\"tid\":%lu},\n",
+                s_name, start, now - (uint64_t)start, _thread_id());
+    }
+    fflush(fp);
+
+    bd_mutex_unlock(&trace_mutex);
+}
@@ -0,0 +1,39 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBBLURAY_TRACE_H_
+#define LIBBLURAY_TRACE_H_
+
+#include "attributes.h"
+
+#include <stdint.h>
+
+/*
+ * Timeline trace (Chrome trace event format)
+ *
+ * Enabled with environment variable BD_TRACE_FILE or bd_set_trace_file().
+ */
+
+/* start timestamp for bd_trace_end(). -1 if tracing is disabled. */
+BD_PRIVATE int64_t bd_trace_begin(void);
+
+/* record event that started at start. detail is optional. */
+BD_PRIVATE void    bd_trace_end(int64_t start, const char *name, const char *detail);
+
+#endif // LIBBLURAY_TRACE_H_